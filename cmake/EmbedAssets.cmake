@@ -0,0 +1,33 @@
+# Packs asset files into one byte array with an index, written as a header for src/Assets.h.
+# Run with cmake -DOUTPUT=<header> -DFILES=<comma separated paths> -P EmbedAssets.cmake from the source directory.
+# Files are looked up at runtime by the same relative paths the game loads them from
+
+string(REPLACE "," ";" FILES "${FILES}")
+set(DATA "")
+set(INDEX "")
+set(OFFSET 0)
+string(REPEAT "0x[0-9a-f][0-9a-f]," 32 ROW)
+list(LENGTH FILES COUNT)
+foreach(FILE ${FILES})
+    file(SIZE ${FILE} SIZE)
+    file(READ ${FILE} HEX HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," HEX "${HEX}")
+    # Break lines every 32 bytes to keep the header readable by editors
+    string(REGEX REPLACE "(${ROW})" "\\1\n" HEX "${HEX}")
+    string(APPEND DATA "// ${FILE}\n${HEX}\n")
+    string(APPEND INDEX "\t{ \"${FILE}\", ${OFFSET}, ${SIZE} },\n")
+    math(EXPR OFFSET "${OFFSET} + ${SIZE}")
+endforeach()
+
+file(WRITE ${OUTPUT}.tmp
+"// Generated by cmake/EmbedAssets.cmake. Do not edit
+#pragma once
+const unsigned char EMBEDDEDASSETDATA[] = {
+${DATA}};
+const EmbeddedAsset EMBEDDEDASSETS[] = {
+${INDEX}};
+const int EMBEDDEDASSETCOUNT = ${COUNT};
+")
+# Only touch the header when the pack changed, so unchanged assets do not rebuild the game
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
@@ -0,0 +1,298 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+#include "TetrisConstants.h"
+#include "Atlas.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// A file packed into the executable. Offset and size are in bytes into EMBEDDEDASSETDATA
+struct EmbeddedAsset {
+	const char* path;
+	size_t offset, size;
+};
+
+// Builds with TETRIS_EMBED_ASSETS (cmake -DTETRIS_EMBED_ASSETS=ON) pack the assets into one array at build time
+// with cmake/EmbedAssets.cmake, so the game runs from any directory. Other builds read them from the assets folder
+#ifdef TETRIS_EMBED_ASSETS
+#include "EmbeddedAssets.h"
+
+// Find a packed file by the path it would be loaded from. Returns nullptr if it was not packed
+const EmbeddedAsset* findEmbeddedAsset(const string& path) {
+	for (int i = 0; i < EMBEDDEDASSETCOUNT; i++)
+		if (path == EMBEDDEDASSETS[i].path)
+			return &EMBEDDEDASSETS[i];
+	return nullptr;
+}
+const unsigned char* getEmbeddedData(const EmbeddedAsset* asset) {
+	return EMBEDDEDASSETDATA + asset->offset;
+}
+#else
+const EmbeddedAsset* findEmbeddedAsset(const string&) {
+	return nullptr;
+}
+const unsigned char* getEmbeddedData(const EmbeddedAsset*) {
+	return nullptr;
+}
+#endif
+
+// Load an asset from the pack if it is there, or from its file otherwise
+template <typename Asset>
+bool loadAsset(Asset& asset, const string& path) {
+	const EmbeddedAsset* packed = findEmbeddedAsset(path);
+	return packed ? asset.loadFromMemory(getEmbeddedData(packed), packed->size) : asset.loadFromFile(path);
+}
+
+// Music stream that times its decoding, which runs on SFML's audio thread
+class TimedMusic : public sf::Music {
+	atomic<long long> decodeTime; // Microseconds
+	atomic<long long> decodedSamples;
+protected:
+	bool onGetData(Chunk& data) override {
+		sf::Clock clock;
+		bool more = sf::Music::onGetData(data);
+		decodeTime += clock.getElapsedTime().asMicroseconds();
+		decodedSamples += data.sampleCount;
+		return more;
+	}
+public:
+	TimedMusic() : decodeTime(0), decodedSamples(0) {}
+	// Milliseconds spent decoding per second of music decoded so far. 0 before any has been decoded
+	float getDecodeCost() const {
+		double seconds = (double)decodedSamples / getChannelCount() / getSampleRate();
+		return decodedSamples > 0 ? decodeTime / 1000.0 / seconds : 0;
+	}
+};
+
+// Background music that either streams or is decoded into memory, picked in the settings.
+// Streaming keeps little in memory but decodes on the audio thread for as long as it plays.
+// Preloading holds the whole track as samples, then loops it with no more reading or decoding
+class BackgroundMusic {
+	TimedMusic stream;
+	sf::Sound preloaded;
+	string path;
+	size_t fileSize; // Bytes of the encoded track
+	int mode; // Mode being played
+	int requestedMode; // Mode picked in the settings. Differs from mode while the track decodes
+	float preloadTime; // Milliseconds to decode the whole track
+
+	// Preloading decodes on its own thread into the buffer not being played, then the main thread swaps which one plays.
+	// Samples are never copied, so the swap costs nothing on the main thread
+	thread decoder;
+	sf::SoundBuffer buffers[2];
+	int playingBuffer; // Buffer preloaded plays. The other is written by the decoder until decodeFinished
+	atomic<bool> decodeFinished;
+	bool decodeSucceeded;
+
+	bool isPlaying() const {
+		return stream.getStatus() == sf::SoundSource::Playing || preloaded.getStatus() == sf::SoundSource::Playing;
+	}
+	// Change the mode being played. Music that was playing carries on from the same point
+	void switchMode(int mode) {
+		bool playing = isPlaying();
+		sf::Time offset = this->mode == BGMSTREAM ? stream.getPlayingOffset() : preloaded.getPlayingOffset();
+		stop();
+		if (mode == BGMPRELOAD) {
+			playingBuffer = 1 - playingBuffer;
+			preloaded.setBuffer(buffers[playingBuffer]);
+		}
+		else { // Free the decoded track
+			preloaded.resetBuffer();
+			buffers[playingBuffer] = sf::SoundBuffer();
+		}
+		this->mode = mode;
+		printCost();
+		if (playing) {
+			play();
+			if (mode == BGMSTREAM)
+				stream.setPlayingOffset(offset);
+			else
+				preloaded.setPlayingOffset(offset);
+		}
+	}
+	void startDecoding() {
+		decodeFinished = false;
+		sf::SoundBuffer& target = buffers[1 - playingBuffer];
+		decoder = thread([this, &target]() {
+			sf::Clock clock;
+			decodeSucceeded = loadAsset(target, path);
+			preloadTime = clock.getElapsedTime().asMicroseconds() / 1000.f;
+			decodeFinished = true;
+		});
+	}
+public:
+	BackgroundMusic() : decodeFinished(false) {
+		fileSize = 0;
+		mode = BGMSTREAM;
+		requestedMode = BGMSTREAM;
+		playingBuffer = 0;
+		preloadTime = 0;
+		decodeSucceeded = false;
+	}
+	~BackgroundMusic() {
+		if (decoder.joinable())
+			decoder.join();
+	}
+	// Open the track for streaming. Packed data lives as long as the program
+	bool open(const string& path) {
+		this->path = path;
+		const EmbeddedAsset* packed = findEmbeddedAsset(path);
+		if (packed) {
+			fileSize = packed->size;
+			return stream.openFromMemory(getEmbeddedData(packed), packed->size);
+		}
+		ifstream file(path, ios::binary | ios::ate);
+		fileSize = file.is_open() ? (size_t)file.tellg() : 0;
+		return stream.openFromFile(path);
+	}
+	// Pick BGMSTREAM or BGMPRELOAD. Streaming applies at once. Preloading keeps streaming while the track
+	// decodes on its own thread and takes over in update. Stays on streaming if the track fails to decode
+	void setMode(int mode) {
+		requestedMode = mode;
+		if (mode == BGMSTREAM && this->mode == BGMPRELOAD)
+			switchMode(BGMSTREAM);
+		else if (mode == BGMPRELOAD && this->mode == BGMSTREAM && !decoder.joinable())
+			startDecoding();
+	}
+	// Swap in a finished decode. Called once per loop by the main thread
+	void update() {
+		if (!decoder.joinable() || !decodeFinished)
+			return;
+		decoder.join();
+		if (!decodeSucceeded)
+			cout << "Music failed to decode. Streaming instead\n";
+		else if (requestedMode == BGMPRELOAD)
+			switchMode(BGMPRELOAD);
+		buffers[1 - playingBuffer] = sf::SoundBuffer(); // Free a decode that is not playing, such as when streaming was picked again
+	}
+	int getMode() const {
+		return mode;
+	}
+	void play() {
+		if (mode == BGMSTREAM)
+			stream.play();
+		else
+			preloaded.play();
+	}
+	void stop() {
+		stream.stop();
+		preloaded.stop();
+	}
+	void setVolume(float volume) {
+		stream.setVolume(volume);
+		preloaded.setVolume(volume);
+	}
+	void setLoop(bool loop) {
+		stream.setLoop(loop);
+		preloaded.setLoop(loop);
+	}
+	// Log the memory and decoding cost of the current mode
+	void printCost() const {
+		cout << fixed << setprecision(1);
+		if (mode == BGMSTREAM) {
+			size_t bufferSize = (size_t)stream.getSampleRate() * stream.getChannelCount() * sizeof(sf::Int16) * BGMSTREAMBUFFERSECONDS;
+			cout << "Music streaming: " << (fileSize + bufferSize) / 1024 << " KB (track and buffers), "
+				<< stream.getDecodeCost() << " ms of decoding per second played\n";
+		}
+		else
+			cout << "Music preloaded: " << buffers[playingBuffer].getSampleCount() * sizeof(sf::Int16) / 1024 << " KB of samples, "
+				<< preloadTime << " ms to decode, none while playing\n";
+	}
+};
+
+// Reads and decodes startup assets on worker threads so the window can open at the same time.
+// Work that needs the GPU, like the atlas texture upload, is left for the main thread after waiting.
+// Times are kept per asset and logged once the first frame is shown, to catch slow starts
+class AssetLoader {
+	struct Job {
+		thread worker;
+		bool loaded = false;
+		float loadTime = 0; // Milliseconds on the worker
+		float waitTime = 0; // Milliseconds the main thread waited for the worker
+		float finishTime = 0; // Milliseconds of main thread work after loading
+	};
+	Job jobs[ASSETCOUNT];
+	vector<pair<string, float>> steps; // Other startup work on the main thread, in milliseconds
+	sf::Clock clock; // Starts with the loader
+	float stepStart;
+	bool reported;
+
+	float getTime() const {
+		return clock.getElapsedTime().asMicroseconds() / 1000.f;
+	}
+	template <typename Load>
+	void launch(int asset, Load load) {
+		Job& job = jobs[asset];
+		job.worker = thread([this, &job, load]() {
+			float start = getTime();
+			job.loaded = load();
+			job.loadTime = getTime() - start;
+		});
+	}
+public:
+	// Start loading. Every asset must outlive the loader
+	AssetLoader(sf::Font& font, TextureAtlas& atlas, sf::SoundBuffer& soundboard, BackgroundMusic& bgm) {
+		stepStart = 0;
+		reported = false;
+		launch(ASSETFONT, [&font]() { return loadAsset(font, FONTFILEPATH); });
+		launch(ASSETATLAS, [&atlas]() {
+			sf::Image tile;
+			if (!loadAsset(tile, BLOCKFILEPATH))
+				return false;
+			atlas.prepare(tile);
+			return true;
+		});
+		launch(ASSETSOUNDS, [&soundboard]() { return loadAsset(soundboard, SOUNDFXFILEPATH); });
+		launch(ASSETMUSIC, [&bgm]() { return bgm.open(BGMFILEPATH); });
+	}
+	~AssetLoader() {
+		for (Job& job : jobs)
+			if (job.worker.joinable())
+				job.worker.join();
+	}
+	// Wait for an asset. Returns false if it failed to load
+	bool wait(int asset) {
+		Job& job = jobs[asset];
+		if (job.worker.joinable()) {
+			float start = getTime();
+			job.worker.join();
+			job.waitTime = getTime() - start;
+		}
+		return job.loaded;
+	}
+	// Wait for an asset, then run the main thread part of loading it. Returns false if either fails
+	template <typename Finish>
+	bool finish(int asset, Finish step) {
+		if (!wait(asset))
+			return false;
+		float start = getTime();
+		jobs[asset].loaded = step();
+		jobs[asset].finishTime = getTime() - start;
+		return jobs[asset].loaded;
+	}
+	// Time other startup work on the main thread so it shows in the log
+	void beginStep() {
+		stepStart = getTime();
+	}
+	void endStep(const string& name) {
+		steps.push_back({ name, getTime() - stepStart });
+	}
+	// Log every time the first time a frame is shown
+	void onFrameShown() {
+		if (reported)
+			return;
+		reported = true;
+		cout << fixed << setprecision(1) << "Startup (ms)\n";
+		for (int i = 0; i < ASSETCOUNT; i++)
+			cout << ASSETNAMES[i] << (findEmbeddedAsset(ASSETPATHS[i]) ? " (packed): " : " (file): ") << jobs[i].loadTime << " loading, " << jobs[i].waitTime << " waited, " << jobs[i].finishTime << " on main thread\n";
+		for (const pair<string, float>& step : steps)
+			cout << step.first << ": " << step.second << "\n";
+		cout << "First frame: " << getTime() << endl;
+	}
+};
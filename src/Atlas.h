@@ -0,0 +1,221 @@
+#pragma once
+#include <cmath>
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Single texture holding the block tile, a solid white texel and pre-rasterized UI shapes.
+// Anything drawn from it can be merged into one VertexBatch without switching textures.
+class TextureAtlas {
+	sf::Texture texture;
+	sf::Image pending; // Prepared image waiting for upload
+	sf::IntRect tileRect, whiteRect, checkRect, cursorRect, triangleRect;
+
+	// Rasterize a shape into a cell. The sampler returns the color at a point in cell coordinates.
+	// Edges are supersampled so the shapes stay smooth when scaled
+	template <typename Sampler>
+	static void rasterizeCell(sf::Image& image, const sf::IntRect& cell, Sampler sampler) {
+		const int samples = 4;
+		for (int y = 0; y < cell.height; y++)
+			for (int x = 0; x < cell.width; x++) {
+				int r = 0, g = 0, b = 0, a = 0;
+				for (int sy = 0; sy < samples; sy++)
+					for (int sx = 0; sx < samples; sx++) {
+						sf::Color color = sampler(x + (sx + 0.5f) / samples, y + (sy + 0.5f) / samples);
+						r += color.r, g += color.g, b += color.b, a += color.a;
+					}
+				int count = samples * samples;
+				image.setPixel(cell.left + x, cell.top + y, sf::Color(r / count, g / count, b / count, a / count));
+			}
+	}
+	// Distance from a point to a line segment
+	static float segmentDistance(sf::Vector2f p, sf::Vector2f a, sf::Vector2f b) {
+		sf::Vector2f ab = b - a, ap = p - a;
+		float t = max(0.f, min(1.f, (ap.x * ab.x + ap.y * ab.y) / (ab.x * ab.x + ab.y * ab.y)));
+		sf::Vector2f closest = a + ab * t;
+		return hypot(p.x - closest.x, p.y - closest.y);
+	}
+	// Place the next cell to the right of the previous one
+	static sf::IntRect nextCell(int& xPos) {
+		sf::IntRect cell(xPos, 0, ATLASCELLSIZE, ATLASCELLSIZE);
+		xPos += ATLASCELLSIZE + ATLASPADDING;
+		return cell;
+	}
+public:
+	// Build the atlas around the block tile image. Returns false if the tile fails to load
+	bool loadFromFile(string tileFile) {
+		sf::Image tile;
+		if (!tile.loadFromFile(tileFile))
+			return false;
+		return build(tile);
+	}
+	bool build(const sf::Image& tile) {
+		prepare(tile);
+		return upload();
+	}
+	// Lay out and rasterize the atlas image. Only touches memory, so it can run on a loading thread
+	void prepare(const sf::Image& tile) {
+		sf::Vector2u tileSize = tile.getSize();
+		int xPos = tileSize.x + ATLASPADDING;
+		tileRect = sf::IntRect(0, 0, tileSize.x, tileSize.y);
+		whiteRect = nextCell(xPos);
+		checkRect = nextCell(xPos);
+		cursorRect = nextCell(xPos);
+		triangleRect = nextCell(xPos);
+
+		sf::Image& image = pending;
+		image.create(xPos, max((int)tileSize.y, ATLASCELLSIZE), INVISIBLE);
+		image.copy(tile, 0, 0);
+
+		const float half = ATLASCELLSIZE / 2.0f;
+		// Solid white block for untextured rectangles
+		rasterizeCell(image, whiteRect, [](float, float) { return WHITE; });
+
+		// Checkbox "X" made of two diagonal strokes
+		rasterizeCell(image, checkRect, [half](float x, float y) {
+			float margin = half * 0.4f, thickness = half * 0.35f;
+			sf::Vector2f p(x, y);
+			float dist = min(segmentDistance(p, { margin, margin }, { half * 2 - margin, half * 2 - margin }),
+				segmentDistance(p, { half * 2 - margin, margin }, { margin, half * 2 - margin }));
+			return dist <= thickness / 2 ? WHITE : INVISIBLE;
+		});
+
+		// Slider cursor. White disk with a black outline baked in, scaled like BAR_CURSOR_RADIUS with a 1 pixel outline
+		rasterizeCell(image, cursorRect, [half](float x, float y) {
+			float dist = hypot(x - half, y - half);
+			if (dist > half)
+				return INVISIBLE;
+			return dist > half * BAR_CURSOR_RADIUS / (BAR_CURSOR_RADIUS + 1.0f) ? BLACK : WHITE;
+		});
+
+		// Menu cursor. Same points as sf::CircleShape(radius, 3) so it can replace one directly
+		rasterizeCell(image, triangleRect, [half](float x, float y) {
+			sf::Vector2f points[3];
+			for (int i = 0; i < 3; i++) {
+				float angle = i * 2 * 3.14159265f / 3 - 3.14159265f / 2;
+				points[i] = { half + half * cos(angle), half + half * sin(angle) };
+			}
+			for (int i = 0; i < 3; i++) {
+				sf::Vector2f a = points[i], b = points[(i + 1) % 3];
+				if ((b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x) < 0)
+					return INVISIBLE;
+			}
+			return WHITE;
+		});
+	}
+	// Send the prepared image to the GPU. Call from the thread that owns the window
+	bool upload() {
+		bool uploaded = texture.loadFromImage(pending);
+		pending = sf::Image();
+		return uploaded;
+	}
+	const sf::Texture& getTexture() const {
+		return texture;
+	}
+	const sf::IntRect& getTileRect() const {
+		return tileRect;
+	}
+	// Texture coordinate inside the white cell. Used by solid quads
+	sf::Vector2f getWhiteTexel() const {
+		return { whiteRect.left + whiteRect.width / 2.0f, whiteRect.top + whiteRect.height / 2.0f };
+	}
+	// Sprites for UI shapes. Sizes are given in pixels on screen
+	sf::Sprite getCheckSprite(float size) const {
+		sf::Sprite sprite(texture, checkRect);
+		sprite.setScale(size / checkRect.width, size / checkRect.height);
+		return sprite;
+	}
+	// Circle cursor with origin at its center. Radius excludes the outline like sf::CircleShape
+	sf::Sprite getCursorSprite(float radius) const {
+		sf::Sprite sprite(texture, cursorRect);
+		sprite.setOrigin(cursorRect.width / 2.0f, cursorRect.height / 2.0f);
+		setCursorRadius(sprite, radius);
+		return sprite;
+	}
+	void setCursorRadius(sf::Sprite& sprite, float radius) const {
+		float scale = (radius + 1) * 2 / cursorRect.width;
+		sprite.setScale(scale, scale);
+	}
+	// Triangle with the same local geometry as sf::CircleShape(radius, 3)
+	sf::Sprite getTriangleSprite(float radius) const {
+		sf::Sprite sprite(texture, triangleRect);
+		sprite.setScale(radius * 2 / triangleRect.width, radius * 2 / triangleRect.height);
+		return sprite;
+	}
+};
+
+// Collects quads that all sample the atlas and draws them with a single call
+class VertexBatch : public sf::Drawable {
+	sf::VertexArray vertices;
+	const sf::Texture* texture;
+	sf::Vector2f whiteTexel;
+
+	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
+		states.texture = texture;
+		target.draw(vertices, states);
+	}
+public:
+	VertexBatch() : vertices(sf::Quads) {
+		texture = nullptr;
+	}
+	VertexBatch(const TextureAtlas& atlas) : vertices(sf::Quads) {
+		texture = &atlas.getTexture();
+		whiteTexel = atlas.getWhiteTexel();
+	}
+	// Remove all quads. Keeps allocated memory for the next frame
+	void clear() {
+		vertices.clear();
+	}
+	size_t getQuadCount() const {
+		return vertices.getVertexCount() / 4;
+	}
+	sf::FloatRect getBounds() const {
+		return vertices.getBounds();
+	}
+	// Add a quad with local corners mapped through a transform
+	void addQuad(const sf::Transform& transform, const sf::FloatRect& local, const sf::FloatRect& texRect, const sf::Color& color) {
+		float right = local.left + local.width, bottom = local.top + local.height;
+		float texRight = texRect.left + texRect.width, texBottom = texRect.top + texRect.height;
+		vertices.append(sf::Vertex(transform.transformPoint(local.left, local.top), color, { texRect.left, texRect.top }));
+		vertices.append(sf::Vertex(transform.transformPoint(right, local.top), color, { texRight, texRect.top }));
+		vertices.append(sf::Vertex(transform.transformPoint(right, bottom), color, { texRight, texBottom }));
+		vertices.append(sf::Vertex(transform.transformPoint(local.left, bottom), color, { texRect.left, texBottom }));
+	}
+	// Add an untextured quad sampled from the white texel
+	void addSolidQuad(const sf::Transform& transform, const sf::FloatRect& local, const sf::Color& color) {
+		addQuad(transform, local, sf::FloatRect(whiteTexel.x, whiteTexel.y, 0, 0), color);
+	}
+	void addSolidQuad(const sf::FloatRect& rect, const sf::Color& color) {
+		addSolidQuad(sf::Transform::Identity, rect, color);
+	}
+	// Add a rectangle shape with its fill and outline
+	void addRectangle(const sf::RectangleShape& rect) {
+		const sf::Transform& transform = rect.getTransform();
+		sf::Vector2f size = rect.getSize();
+		float t = rect.getOutlineThickness();
+		if (rect.getFillColor().a > 0)
+			addSolidQuad(transform, { 0, 0, size.x, size.y }, rect.getFillColor());
+		if (t != 0 && rect.getOutlineColor().a > 0) {
+			const sf::Color& outline = rect.getOutlineColor();
+			addSolidQuad(transform, { -t, -t, size.x + t * 2, t }, outline);
+			addSolidQuad(transform, { -t, size.y, size.x + t * 2, t }, outline);
+			addSolidQuad(transform, { -t, 0, t, size.y }, outline);
+			addSolidQuad(transform, { size.x, 0, t, size.y }, outline);
+		}
+	}
+	// Add prepared vertices moved by an offset
+	void addVertices(const sf::Vertex* source, size_t count, sf::Vector2f offset) {
+		for (size_t i = 0; i < count; i++) {
+			sf::Vertex vertex = source[i];
+			vertex.position += offset;
+			vertices.append(vertex);
+		}
+	}
+	// Add a sprite. The sprite must use the atlas texture
+	void addSprite(const sf::Sprite& sprite) {
+		const sf::IntRect& texRect = sprite.getTextureRect();
+		addQuad(sprite.getTransform(), { 0, 0, (float)abs(texRect.width), (float)abs(texRect.height) }, sf::FloatRect(texRect), sprite.getColor());
+	}
+};
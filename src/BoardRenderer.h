@@ -0,0 +1,336 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
+#include "Atlas.h"
+#include "Drawing.h"
+#include "Tetromino.h"
+#include "Snapshot.h"
+#include "Tile.h"
+#include "Profiler.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Hold and queue piece quads for every piece in every pallete, built once.
+// Drawing a preview copies its four quads with an offset, so a new queue only changes piece indices
+class PreviewGeometry {
+	vector<sf::Vertex> vertices; // 16 per piece. Pieces in code order within each pallete
+public:
+	PreviewGeometry() {}
+	PreviewGeometry(const TextureAtlas& atlas, float scaleFactor) {
+		vector<Tetromino*> shapes = { new IPiece, new JPiece, new LPiece, new OPiece, new SPiece, new ZPiece, new TPiece };
+		const sf::IntRect& tileRect = atlas.getTileRect();
+		float width = tileRect.width * scaleFactor, height = tileRect.height * scaleFactor;
+		float texLeft = tileRect.left, texTop = tileRect.top;
+		float texRight = texLeft + tileRect.width, texBottom = texTop + tileRect.height;
+		for (const vector<sf::Color>& pallete : PIECECOLORSETS)
+			for (int i = 0; i < shapes.size(); i++)
+				for (const sf::Vector2i& pos : shapes[i]->getPositions()) {
+					// Same layout as Tetromino::getPieceSprite
+					float x = (pos.y - 3) * TILESIZE * scaleFactor, y = pos.x * TILESIZE * scaleFactor;
+					vertices.push_back(sf::Vertex({ x, y }, pallete[i], { texLeft, texTop }));
+					vertices.push_back(sf::Vertex({ x + width, y }, pallete[i], { texRight, texTop }));
+					vertices.push_back(sf::Vertex({ x + width, y + height }, pallete[i], { texRight, texBottom }));
+					vertices.push_back(sf::Vertex({ x, y + height }, pallete[i], { texLeft, texBottom }));
+				}
+		for (Tetromino* shape : shapes)
+			delete shape;
+	}
+	// Add a piece with its anchor at a position
+	void addPiece(VertexBatch& batch, int pallete, int pieceCode, sf::Vector2f position) const {
+		batch.addVertices(&vertices[(pallete * 7 + pieceCode) * 16], 16, position);
+	}
+};
+
+// Draws a board from its snapshot. Owns every visual of the board so the simulation thread
+// never touches SFML drawables. Only used by the main thread
+class BoardRenderer {
+#pragma region Attributes
+	// HUD Items
+	vector<SfRectangleAtHome> screenRects;
+	sf::FloatRect gameBounds, holdBounds, queueBounds;
+	SfTextAtHome holdText, nextText, gamemodeText;
+	vector<SfRectangleAtHome> lines;
+	// Static HUD items are drawn once into three stacked layers: rectangles, grid lines, and an overlay
+	// with the top cover rectangle and text. Only redrawn when one of them changes
+	sf::RenderTexture hudCache;
+	vector<sf::Sprite> hudLayers;
+	bool hudDirty;
+
+	TextureAtlas* atlas; // Block tile and UI shapes
+	VertexBatch boardBatch; // Rebuilt every frame. Draws the board and HUD shapes in one call
+	PreviewGeometry previews; // Hold and queue pieces
+	sf::Vector2f holdPosition, queuePositions[NEXTPIECECOUNT];
+	GarbageStack garbStack; // Visuals for garbage
+	// Clear texts are laid out once. The clear text picks a prebuilt name and the combo text only rebuilds its digits
+	SfTextAtHome speedupText, backToBackText, allClearText;
+	vector<SfTextAtHome> clearNameTexts; // One per clear type
+	CounterText comboText;
+	int clearType;
+	vector<sf::Vector2f> clearTextTimes; // Duration and fade duration of each clear text
+	EffectSystem effects; // Clear texts, line clear flashes, and the death fill
+	float frameTime; // Frame timestamp of the last update
+
+	// Snapshot values the visuals were last built from
+	int colorPallete, nextPieceCount;
+	int clearTextSerials[CLEARANIMATIONCOUNT];
+	int deathCount, lineClearSerial;
+	bool holdEnabled;
+#pragma endregion
+
+	// Add one block tile at a board position, moved down by a number of pixels
+	void addTile(int row, int col, const sf::Color& color, float offsetY = 0) {
+		const sf::IntRect& tileRect = atlas->getTileRect();
+		sf::FloatRect dest(gameBounds.left + col * TILESIZE + 1, gameBounds.top + (row - 2) * TILESIZE + 1 + offsetY, tileRect.width, tileRect.height);
+		boardBatch.addQuad(sf::Transform::Identity, dest, sf::FloatRect(tileRect), color);
+	}
+public:
+	BoardRenderer(sf::Vector2f gamePos, sf::Font& font, TextureAtlas& atlas) {
+		hudDirty = true;
+		setHUD(gamePos, font);
+		this->atlas = &atlas;
+		boardBatch = VertexBatch(atlas);
+		speedupText = SfTextAtHome(font, WHITE, "SPEED UP", GAMETEXTSIZE * 2, { gamePos.x + GAMEWIDTH / 2, gamePos.y }, true, false, true);
+		for (const string& name : CLEARNAMES)
+			clearNameTexts.push_back(SfTextAtHome(font, WHITE, name, CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f }));
+		backToBackText = SfTextAtHome(font, WHITE, "Back-to-Back", CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f + MENUSPACING });
+		comboText = CounterText(font, WHITE, "", "X Combo", CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f + MENUSPACING * 2 });
+		allClearText = SfTextAtHome(font, WHITE, "All Clear", CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f + MENUSPACING * 3 });
+		clearType = TSPINTRIPLECLEAR;
+		clearTextTimes = { { 1, 1 }, { 0, 2.5f }, { 0, 2.5f }, { 0, 2.5f }, { 0, 2.5f } };
+		garbStack = GarbageStack({ gameBounds.left, gameBounds.top }, atlas);
+		effects = EffectSystem(atlas);
+		frameTime = 0;
+
+		previews = PreviewGeometry(atlas, HUDPIECESCALE);
+		for (int i = 0; i < CLEARANIMATIONCOUNT; i++)
+			clearTextSerials[i] = 0;
+		colorPallete = 0, deathCount = 0, lineClearSerial = 0;
+		nextPieceCount = NEXTPIECECOUNT;
+		holdEnabled = true;
+	}
+	// Create HUD on game position
+	void setHUD(sf::Vector2f gamePos, sf::Font& font) {
+		// Rectangles for game screen, hold, queue, garbage bin, and top row,
+		screenRects.push_back(SfRectangleAtHome(BLACK, { GAMEWIDTH, GAMEHEIGHT },
+			gamePos, false, WHITE, LINEWIDTH));
+		screenRects.push_back(SfRectangleAtHome(BLACK, { TILESIZE * 4, TILESIZE * 4 },
+			{ gamePos.x - TILESIZE * 4.5f - LINEWIDTH, gamePos.y + LINEWIDTH }, false, WHITE, LINEWIDTH));
+		screenRects.push_back(SfRectangleAtHome(BLACK, { TILESIZE * 4, GAMEHEIGHT / 9 * NEXTPIECECOUNT },
+			{ gamePos.x + GAMEWIDTH + LINEWIDTH, gamePos.y + LINEWIDTH }, false, WHITE, LINEWIDTH));
+		screenRects.push_back(SfRectangleAtHome(BLACK, { TILESIZE / 2, GAMEHEIGHT - LINEWIDTH },
+			{ gamePos.x - TILESIZE / 2 - LINEWIDTH, gamePos.y + LINEWIDTH }, false, WHITE, LINEWIDTH));
+
+		// Rectangles to show a couple pixels of the very top row
+		screenRects.push_back(SfRectangleAtHome(BLACK, { GAMEWIDTH, TOPROWPIXELS },
+			{ gamePos.x, gamePos.y - TOPROWPIXELS }, false, WHITE, LINEWIDTH));
+		screenRects.push_back(SfRectangleAtHome(BLUE, { GAMEWIDTH + 1, TILESIZE - 9 },
+			{ gamePos.x - 1, gamePos.y - TILESIZE - 1 }));
+
+		// Get bounds of first three rectangles (game, hold, queue)
+		gameBounds = screenRects[0].getGlobalBounds();
+		holdBounds = screenRects[1].getGlobalBounds();
+		queueBounds = screenRects[2].getGlobalBounds();
+
+		// Anchors for the hold and queue pieces
+		holdPosition = { holdBounds.left + TILESIZE * HUDPIECESCALE, holdBounds.top + TILESIZE / 2.0f * HUDPIECESCALE };
+		for (int i = 0; i < NEXTPIECECOUNT; i++)
+			queuePositions[i] = { queueBounds.left + TILESIZE * HUDPIECESCALE, queueBounds.top + i * 2.5f * TILESIZE * HUDPIECESCALE + TILESIZE / 2.0f };
+
+		// Generate all static text on game screen
+		holdText = SfTextAtHome(font, WHITE, "Hold", GAMETEXTSIZE, { holdBounds.left + holdBounds.width / 2, holdBounds.top - GAMETEXTSIZE }, true, false, true);
+		nextText = SfTextAtHome(font, WHITE, "Next", GAMETEXTSIZE, { queueBounds.left + queueBounds.width / 2, queueBounds.top - GAMETEXTSIZE }, true, false, true);
+		gamemodeText = SfTextAtHome(font, WHITE, "Classic Mode", GAMETEXTSIZE * 2, { gameBounds.left + gameBounds.width / 2, gameBounds.top - GAMETEXTSIZE * 2 }, true, false, true);
+
+		// Generate game field lines
+		for (int i = 1; i < NUMROWS; i++) { // Horizontal lines
+			lines.push_back(SfRectangleAtHome(SEETHROUGH, { GAMEWIDTH, LINEWIDTH }, { gameBounds.left, gameBounds.top + i * TILESIZE - 1 }));
+		}
+		for (int j = 1; j < NUMCOLS; j++) { // Vertical lines
+			lines.push_back(SfRectangleAtHome(SEETHROUGH, { LINEWIDTH, GAMEHEIGHT + TOPROWPIXELS },
+				{ gameBounds.left + j * TILESIZE - 1, gameBounds.top - TOPROWPIXELS }));
+		}
+	}
+	void setGamemodeTextString(string str) {
+		gamemodeText.setString(str);
+		hudDirty = true;
+	}
+	void setGamemodeTextXPos(float x) {
+		gamemodeText.setPosition(x, gamemodeText.getPosition().y);
+		hudDirty = true;
+	}
+	// Bring visuals up to date with a snapshot at a frame timestamp. Only rebuilds what the snapshot changed
+	void update(const BoardSnapshot& snapshot, float now) {
+		frameTime = now;
+		// Resize the hold and queue boxes when their settings change
+		if (snapshot.holdEnabled != holdEnabled || snapshot.nextPieceCount != nextPieceCount) {
+			holdEnabled = snapshot.holdEnabled;
+			nextPieceCount = snapshot.nextPieceCount;
+			screenRects[1].setSize({ TILESIZE * 4.0f * holdEnabled, TILESIZE * 4.0f * holdEnabled });
+			screenRects[2].setSize({ nextPieceCount > 0 ? TILESIZE * 4.0f : 0, GAMEHEIGHT / 9.0f * nextPieceCount });
+			hudDirty = true;
+		}
+		colorPallete = snapshot.colorPallete;
+		// Start effects for events since the last update
+		for (int i = 0; i < CLEARANIMATIONCOUNT; i++)
+			if (snapshot.clearTextSerials[i] != clearTextSerials[i]) {
+				clearTextSerials[i] = snapshot.clearTextSerials[i];
+				if (i == 1)
+					clearType = snapshot.clearTextValues[i];
+				else if (i == 3)
+					comboText.setValue(snapshot.clearTextValues[i]);
+				effects.play(TEXTEFFECT, now, clearTextTimes[i].x, clearTextTimes[i].y, ORIGIN, i);
+			}
+		if (snapshot.lineClearSerial != lineClearSerial) {
+			lineClearSerial = snapshot.lineClearSerial;
+			for (int row = 2; row < REALNUMROWS; row++) // Hidden rows are never seen
+				if (snapshot.clearedRows & (1u << row)) {
+					sf::Vector2f rowPos(gameBounds.left, gameBounds.top + (row - 2) * TILESIZE);
+					effects.play(FLASHEFFECT, now, LINEFLASHDURATION, 0, rowPos, row);
+					effects.play(PARTICLEEFFECT, now, PARTICLEDURATION, 0, rowPos, lineClearSerial * REALNUMROWS + row);
+				}
+		}
+		if (snapshot.deathCount != deathCount) {
+			deathCount = snapshot.deathCount;
+			effects.play(DEATHEFFECT, now, 2, 0.2f, { gameBounds.left, gameBounds.top });
+		}
+		effects.update(now);
+		// Update garbageStack if gameMode is sandbox or PVP
+		if (snapshot.gameMode != CLASSIC)
+			garbStack.updateStack(snapshot.garbage, snapshot.garbageCount);
+	}
+	// Draw the static HUD into the cache. Each layer covers the same screen area
+	void renderHUD() {
+		PROFILE_ZONE(PROFILERHUD);
+		// Find the area covered by all static items
+		sf::FloatRect area = screenRects[0].getGlobalBounds();
+		auto expand = [&area](const sf::FloatRect& rect) {
+			if (rect.width <= 0 || rect.height <= 0)
+				return;
+			float right = max(area.left + area.width, rect.left + rect.width);
+			float bottom = max(area.top + area.height, rect.top + rect.height);
+			area.left = min(area.left, rect.left);
+			area.top = min(area.top, rect.top);
+			area.width = right - area.left;
+			area.height = bottom - area.top;
+		};
+		for (const SfRectangleAtHome& rect : screenRects)
+			expand(rect.getGlobalBounds());
+		for (const SfRectangleAtHome& line : lines)
+			expand(line.getGlobalBounds());
+		expand(holdText.getGlobalBounds());
+		expand(nextText.getGlobalBounds());
+		expand(gamemodeText.getGlobalBounds());
+		area.left = floor(area.left), area.top = floor(area.top);
+		area.width = ceil(area.width) + 1, area.height = ceil(area.height) + 1;
+
+		const int layerCount = 3;
+		sf::Vector2u size((unsigned int)area.width, (unsigned int)area.height);
+		if (hudCache.getSize() != sf::Vector2u(size.x, size.y * layerCount))
+			hudCache.create(size.x, size.y * layerCount);
+		hudCache.clear(sf::Color::Transparent);
+		VertexBatch batch(*atlas);
+		for (int layer = 0; layer < layerCount; layer++) {
+			sf::View view(area);
+			view.setViewport(sf::FloatRect(0, layer / (float)layerCount, 1, 1 / (float)layerCount));
+			hudCache.setView(view);
+			batch.clear();
+			if (layer == 0) { // Outline rectangles. Last rectangle covers the hidden rows and goes in the overlay
+				for (int i = 0; i < screenRects.size() - 1; i++)
+					batch.addRectangle(screenRects[i]);
+				hudCache.draw(batch);
+			}
+			else if (layer == 1) { // Grid lines. Hidden while paused
+				for (const SfRectangleAtHome& line : lines)
+					batch.addRectangle(line);
+				hudCache.draw(batch);
+			}
+			else { // Overlay drawn above the tiles
+				batch.addRectangle(screenRects.back());
+				hudCache.draw(batch);
+				if (holdEnabled)
+					hudCache.draw(holdText);
+				if (nextPieceCount > 0)
+					hudCache.draw(nextText);
+				hudCache.draw(gamemodeText);
+			}
+		}
+		hudCache.display();
+
+		hudLayers.clear();
+		for (int layer = 0; layer < layerCount; layer++) {
+			sf::Sprite sprite(hudCache.getTexture(), sf::IntRect(0, size.y * layer, size.x, size.y));
+			sprite.setPosition(area.left, area.top);
+			hudLayers.push_back(sprite);
+		}
+		hudDirty = false;
+	}
+	// Draw all tiles, held piece, and queue pieces
+	// The static HUD is blitted from its cache. Everything else except text goes
+	// through the atlas batch so the board is a single draw call
+	void drawScreen(sf::RenderTarget& target, const BoardSnapshot& snapshot, float now) {
+		update(snapshot, now);
+		if (hudDirty)
+			renderHUD();
+		// Cache holds premultiplied colors from being drawn onto a transparent texture
+		sf::RenderStates cached(sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha));
+		target.draw(hudLayers[0], cached);
+		if (!snapshot.paused)
+			target.draw(hudLayers[1], cached);
+
+		boardBatch.clear();
+		if (!snapshot.paused) {
+			// The falling piece slides toward the next row between gravity steps. Board state stays on whole rows
+			float fallOffset = snapshot.fallProgress * TILESIZE;
+			for (int i = 1; i < REALNUMROWS; i++) {
+				for (int j = 0; j < NUMCOLS; j++) {
+					unsigned char cell = snapshot.cells[i][j];
+					if (cell & CELLACTIVE)
+						addTile(i, j, getCellColor(cell, colorPallete), fallOffset);
+					else if (cell & (CELLLOCKED | CELLGHOST))
+						addTile(i, j, getCellColor(cell, colorPallete));
+				}
+			}
+			if (snapshot.heldPiece >= 0)
+				previews.addPiece(boardBatch, colorPallete, snapshot.heldPiece, holdPosition);
+			for (int i = 0; i < nextPieceCount; i++)
+				previews.addPiece(boardBatch, colorPallete, snapshot.nextPieces[i], queuePositions[i]);
+
+			// Draw garbage stack if game mode is sandbox or PVP
+			if (snapshot.gameMode != CLASSIC)
+				garbStack.addToBatch(boardBatch);
+		}
+		effects.addToBatch(boardBatch, now);
+		target.draw(boardBatch);
+		target.draw(hudLayers[2], cached);
+
+		// Only texts that are still showing are touched
+		for (int i = 0; i < CLEARANIMATIONCOUNT; i++) {
+			float alpha = effects.getTextAlpha(i, now);
+			if (alpha <= 0)
+				continue;
+			sf::Color color = WHITE;
+			color.a = alpha * 255;
+			if (i == 3) {
+				comboText.setFillColor(color);
+				target.draw(comboText);
+				continue;
+			}
+			sf::Text& text = i == 0 ? speedupText : i == 1 ? clearNameTexts[clearType] : i == 2 ? backToBackText : allClearText;
+			text.setFillColor(color);
+			target.draw(text);
+		}
+	}
+	// Check if the death animation for a screen's latest game over has finished playing.
+	// A game over the renderer has not drawn yet counts as not finished
+	bool isDeathAnimationOver(int deathCount) {
+		return deathCount == this->deathCount && !effects.isPlaying(DEATHEFFECT);
+	}
+	// Return true if the board changes without input. Paused boards only change while an effect is running
+	bool isAnimating(const BoardSnapshot& snapshot, float now) {
+		update(snapshot, now);
+		return !snapshot.paused || snapshot.gameOver || effects.getCount() > 0;
+	}
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <SFML/Window.hpp>
+#include "TetrisConstants.h"
+#include "Mechanisms.h"
+#include "Screen.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// One player action. Humans, bots, and replays all drive boards with these, so nothing here depends on SFML input
+struct Command {
+	int action; // ACTIONHARDDROP to ACTIONHOLD
+	bool pressed; // Movement is held and released. Other actions only act when pressed
+	float time; // Input time in milliseconds
+	int sequence; // Press number followed by the latency harness. 0 if not followed
+};
+
+// Commands for one board, filled during a tick and run by the simulation in order
+class CommandBuffer {
+	Command commands[COMMANDBUFFERSIZE];
+	int count;
+public:
+	CommandBuffer() {
+		count = 0;
+	}
+	// Returns false if the buffer is full
+	bool push(const Command& command) {
+		if (count >= COMMANDBUFFERSIZE)
+			return false;
+		commands[count++] = command;
+		return true;
+	}
+	int size() const {
+		return count;
+	}
+	const Command& operator[](int index) const {
+		return commands[index];
+	}
+	void clear() {
+		count = 0;
+	}
+};
+
+// Key to action lookup for one player, built from their keybinds
+class ActionTable {
+	signed char actions[sf::Keyboard::KeyCount];
+public:
+	ActionTable() {
+		clear();
+	}
+	void clear() {
+		fill(actions, actions + sf::Keyboard::KeyCount, ACTIONNONE);
+	}
+	// Keys come in action order from KeySet::getSet. A key bound twice keeps its first action
+	void build(KeySet* keys) {
+		clear();
+		vector<sf::Keyboard::Key*> set = keys->getSet();
+		for (int action = ACTIONCOUNT - 1; action >= 0; action--)
+			if (*set[action] >= 0 && *set[action] < sf::Keyboard::KeyCount)
+				actions[*set[action]] = action;
+	}
+	int getAction(sf::Keyboard::Key key) const {
+		return key >= 0 && key < sf::Keyboard::KeyCount ? actions[key] : ACTIONNONE;
+	}
+};
+
+// Run a command on a board. Movement goes to the player's auto repeat, or moves one cell for players without one such as bots.
+// Returns true if the command reached the board
+bool runCommand(Screen* screen, KeyDAS* das, const Command& command) {
+	bool movement = command.action == ACTIONLEFT || command.action == ACTIONDOWN || command.action == ACTIONRIGHT;
+	if (movement && das) {
+		if (command.pressed)
+			das->pressAction(command.action, command.time);
+		else
+			das->releaseAction(command.action, command.time);
+	}
+	if (!command.pressed || screen->getPaused())
+		return false;
+	switch (command.action)
+	{
+	case ACTIONHARDDROP:
+		screen->movePiece(3);
+		break;
+	case ACTIONLEFT:
+	case ACTIONDOWN:
+	case ACTIONRIGHT:
+		if (!das) // Auto repeat makes the first move later in the same tick
+			screen->shiftPiece(command.action - ACTIONLEFT, 1);
+		break;
+	case ACTIONSPINCW:
+		screen->spinPiece(true);
+		break;
+	case ACTIONSPINCCW:
+		screen->spinPiece(false);
+		break;
+	case ACTIONHOLD:
+		screen->holdPiece();
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
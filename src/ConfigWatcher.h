@@ -0,0 +1,113 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <SFML/System.hpp>
+#include "TetrisConstants.h"
+#include "GameSettings.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Watches the config file on its own thread so settings can be tuned by editing the file while the game runs.
+// Each change is parsed on that thread and handed to the main thread, which applies it while holding the state lock,
+// so it lands between simulation ticks. Uses inotify on Linux and checks the modified time elsewhere
+class ConfigWatcher {
+	string path;
+	mutex lock;
+	vector<int> pending; // Newest parsed values not yet taken. Guarded by lock
+	bool hasPending;
+	atomic<bool> running;
+	thread worker;
+
+	void reload() {
+		ifstream inFile(path);
+		if (!inFile.is_open()) // Editors that delete before writing leave a moment with no file
+			return;
+		vector<int> values;
+		ConfigFile::parse(inFile, values);
+		lock_guard<mutex> guard(lock);
+		pending = values;
+		hasPending = true;
+	}
+#ifdef __linux__
+	// Watch the folder rather than the file, since saving by rename replaces the file being watched
+	void run() {
+		filesystem::path file(path);
+		string folder = file.has_parent_path() ? file.parent_path().string() : ".";
+		string name = file.filename().string();
+		int notifier = inotify_init1(IN_NONBLOCK);
+		if (notifier < 0 || inotify_add_watch(notifier, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+			cout << "Config file cannot be watched for changes\n";
+			if (notifier >= 0)
+				::close(notifier);
+			return;
+		}
+		alignas(inotify_event) char buffer[4096];
+		pollfd poller = { notifier, POLLIN, 0 };
+		while (running) {
+			if (poll(&poller, 1, CONFIGWATCHDELAY) <= 0)
+				continue;
+			bool changed = false;
+			ssize_t length;
+			while ((length = ::read(notifier, buffer, sizeof(buffer))) > 0)
+				for (char* next = buffer; next < buffer + length; ) {
+					inotify_event* event = (inotify_event*)next;
+					if (event->len > 0 && name == event->name)
+						changed = true;
+					next += sizeof(inotify_event) + event->len;
+				}
+			if (changed)
+				reload();
+		}
+		::close(notifier);
+	}
+#else
+	void run() {
+		error_code error;
+		filesystem::file_time_type lastWrite = filesystem::last_write_time(path, error);
+		while (running) {
+			sf::sleep(sf::milliseconds(CONFIGWATCHDELAY));
+			filesystem::file_time_type writeTime = filesystem::last_write_time(path, error);
+			if (!error && writeTime != lastWrite) {
+				lastWrite = writeTime;
+				reload();
+			}
+		}
+	}
+#endif
+public:
+	ConfigWatcher(string path) : running(false) {
+		this->path = path;
+		hasPending = false;
+	}
+	~ConfigWatcher() {
+		stop();
+	}
+	void start() {
+		running = true;
+		worker = thread(&ConfigWatcher::run, this);
+	}
+	void stop() {
+		if (!worker.joinable())
+			return;
+		running = false;
+		worker.join();
+	}
+	// Take the newest values read from the file. Returns false if the file has not changed since the last call
+	bool takeChanges(vector<int>& values) {
+		lock_guard<mutex> guard(lock);
+		if (!hasPending)
+			return false;
+		values = pending;
+		hasPending = false;
+		return true;
+	}
+};
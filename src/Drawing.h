@@ -1,11 +1,23 @@
 #pragma once
 #include <vector>
-#include "Tile.h"
+#include "Atlas.h"
 #include "Mechanisms.h"
+#include "Tile.h"
 using namespace TetrisVariables;
 using namespace std;
 
 #pragma region Sf Sprites At Home
+// Smallest rectangle containing both rectangles
+sf::FloatRect getUnion(const sf::FloatRect& a, const sf::FloatRect& b) {
+	float left = min(a.left, b.left), top = min(a.top, b.top);
+	float right = max(a.left + a.width, b.left + b.width), bottom = max(a.top + a.height, b.top + b.height);
+	return sf::FloatRect(left, top, right - left, bottom - top);
+}
+// Rectangle grown by a margin on every side
+sf::FloatRect getInflated(const sf::FloatRect& rect, float margin) {
+	return sf::FloatRect(rect.left - margin, rect.top - margin, rect.width + margin * 2, rect.height + margin * 2);
+}
+
 // Class for easy sf::Text generation. Replaces the setText function
 class SfTextAtHome : public sf::Text {
 public:
@@ -37,6 +49,89 @@ public:
 	}
 };
 
+// Text with a number between a fixed prefix and suffix. The labels are laid out once and digits are
+// copied from glyph quads taken from the font up front, so a new value only rewrites a few vertices
+class CounterText : public sf::Drawable {
+	SfTextAtHome prefix, suffix;
+	const sf::Font* font;
+	unsigned int textSize;
+	sf::Vertex digitQuads[10][4]; // Glyph quad of each digit with the pen at the origin
+	float digitAdvances[10];
+	sf::VertexArray digits; // Quads of the current value, relative to digitsPos
+	sf::Vector2f digitsPos; // Pen position after the prefix
+	int value;
+
+	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
+		target.draw(prefix, states);
+		target.draw(suffix, states);
+		states.texture = &font->getTexture(textSize);
+		states.transform.translate(digitsPos);
+		target.draw(digits, states);
+	}
+public:
+	CounterText() {
+		font = nullptr;
+		textSize = 0;
+		value = -1;
+	}
+	CounterText(sf::Font& font, sf::Color color, string prefixText, string suffixText, unsigned int textSize, sf::Vector2f position) : digits(sf::Quads) {
+		this->font = &font;
+		this->textSize = textSize;
+		prefix = SfTextAtHome(font, color, prefixText, textSize, position);
+		suffix = SfTextAtHome(font, color, suffixText, textSize, position);
+		digitsPos = prefix.findCharacterPos(prefixText.size());
+		// Same quad layout as sf::Text. The baseline sits one character size below the top
+		const float padding = 1;
+		for (int i = 0; i < 10; i++) {
+			const sf::Glyph& glyph = font.getGlyph('0' + i, textSize, true);
+			float left = glyph.bounds.left - padding, top = glyph.bounds.top + textSize - padding;
+			float right = glyph.bounds.left + glyph.bounds.width + padding, bottom = glyph.bounds.top + glyph.bounds.height + textSize + padding;
+			float texLeft = glyph.textureRect.left - padding, texTop = glyph.textureRect.top - padding;
+			float texRight = glyph.textureRect.left + glyph.textureRect.width + padding, texBottom = glyph.textureRect.top + glyph.textureRect.height + padding;
+			digitQuads[i][0] = sf::Vertex({ left, top }, color, { texLeft, texTop });
+			digitQuads[i][1] = sf::Vertex({ right, top }, color, { texRight, texTop });
+			digitQuads[i][2] = sf::Vertex({ right, bottom }, color, { texRight, texBottom });
+			digitQuads[i][3] = sf::Vertex({ left, bottom }, color, { texLeft, texBottom });
+			digitAdvances[i] = glyph.advance;
+		}
+		value = -1;
+		setValue(0);
+	}
+	// Show a new value. Does nothing if the value is unchanged. Negative values show as 0
+	void setValue(int value) {
+		value = max(value, 0);
+		if (value == this->value)
+			return;
+		this->value = value;
+		int digitValues[10], length = 0;
+		do {
+			digitValues[length++] = value % 10;
+			value /= 10;
+		} while (value > 0);
+
+		digits.clear();
+		float x = 0;
+		for (int i = length - 1; i >= 0; i--) {
+			for (sf::Vertex vertex : digitQuads[digitValues[i]]) {
+				vertex.position.x += x;
+				digits.append(vertex);
+			}
+			x += digitAdvances[digitValues[i]];
+		}
+		suffix.setPosition(digitsPos.x + x, prefix.getPosition().y);
+	}
+	// Recolor labels and digits without changing their layout
+	void setFillColor(const sf::Color& color) {
+		prefix.setFillColor(color);
+		suffix.setFillColor(color);
+		for (auto& quad : digitQuads)
+			for (sf::Vertex& vertex : quad)
+				vertex.color = color;
+		for (size_t i = 0; i < digits.getVertexCount(); i++)
+			digits[i].color = color;
+	}
+};
+
 // Class for easy sf::RectangleShape generation.
 class SfRectangleAtHome : public sf::RectangleShape {
 public:
@@ -87,7 +182,7 @@ class Checkbox : public sf::Drawable {
 protected:
 	SfRectangleAtHome box;
 	sf::FloatRect bounds;
-	SfTextAtHome check, hoverCheck;
+	sf::Sprite check, hoverCheck; // "X" shapes from the texture atlas
 	bool checked, hovering;
 
 	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
@@ -98,21 +193,29 @@ protected:
 			target.draw(hoverCheck, states);
 	}
 public:
-	Checkbox(float size, float left, float top, bool checked, sf::Font& font) {
+	Checkbox(float size, float left, float top, bool checked, const TextureAtlas& atlas) {
 		// White outline box
 		box = SfRectangleAtHome(BLUE, { size, size }, { left, top }, false, WHITE, LINEWIDTH);
 		bounds = box.getGlobalBounds();
 
 		// "X" to toggle
-		check = SfTextAtHome(font, WHITE, "X", size, { bounds.left + bounds.width / 2, bounds.top + bounds.height / 2 }, true, false, true);
-		check.move(0, -check.getGlobalBounds().height / 2);
-		sf::FloatRect textBounds = check.getGlobalBounds();
+		check = atlas.getCheckSprite(size);
+		check.setPosition(left, top);
 		this->checked = checked;
 
 		hoverCheck = check;
-		hoverCheck.setFillColor(HOVERCHECKBOX);
+		hoverCheck.setColor(HOVERCHECKBOX);
 		hovering = false;
 	}
+	virtual ~Checkbox() {}
+	// Add box and check to a batch instead of drawing them separately
+	virtual void addToBatch(VertexBatch& batch) const {
+		batch.addRectangle(box);
+		if (checked)
+			batch.addSprite(check);
+		else if (hovering)
+			batch.addSprite(hoverCheck);
+	}
 	void setChecked(bool val) {
 		checked = val;
 	}
@@ -129,27 +232,31 @@ public:
 
 // Inherited from checkbox. Has two clickable arrows. Text is a range of numbers
 class IncrementalBox : public Checkbox {
-	sf::CircleShape leftArrow;
+	SfTextAtHome numberText;
+	sf::Sprite leftArrow;
 	sf::FloatRect leftBound;
-	sf::CircleShape rightArrow;
+	sf::Sprite rightArrow;
 	sf::FloatRect rightBound;
 	int min, max, currentNum;
 
 	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
 		target.draw(box, states);
-		target.draw(check, states);
+		target.draw(numberText, states);
 		target.draw(leftArrow, states);
 		target.draw(rightArrow, states);
 	}
 public:
-	IncrementalBox(float size, float left, float top, int min, int max, sf::Font& font) : Checkbox(size, left, top, true, font) {
+	IncrementalBox(float size, float left, float top, int min, int max, sf::Font& font, const TextureAtlas& atlas) : Checkbox(size, left, top, true, atlas) {
+		numberText = SfTextAtHome(font, WHITE, "X", size, { bounds.left + bounds.width / 2, bounds.top + bounds.height / 2 }, true, false, true);
+		numberText.move(0, -numberText.getGlobalBounds().height / 2);
+
 		// Clickable left and right arrows
-		leftArrow = sf::CircleShape(size / 2, 3);
-		leftArrow.setOrigin(size / 2, 0);
+		leftArrow = atlas.getTriangleSprite(size / 2);
+		leftArrow.setOrigin(leftArrow.getLocalBounds().width / 2, 0);
 		leftArrow.rotate(270);
 		leftArrow.setPosition(bounds.left - 30, bounds.top + bounds.height / 2);
 
-		rightArrow = sf::CircleShape(size / 2, 3);
+		rightArrow = atlas.getTriangleSprite(size / 2);
 		rightArrow.rotate(90);
 		rightArrow.setPosition(bounds.left + bounds.width + 30, bounds.top);
 
@@ -162,8 +269,17 @@ public:
 		currentNum = min;
 		updateString();
 	}
+	// Number text is drawn separately since it uses the font texture
+	void addToBatch(VertexBatch& batch) const {
+		batch.addRectangle(box);
+		batch.addSprite(leftArrow);
+		batch.addSprite(rightArrow);
+	}
+	const sf::Text& getNumberText() const {
+		return numberText;
+	}
 	void updateString() {
-		check.setString(to_string(currentNum));
+		numberText.setString(to_string(currentNum));
 	}
 	sf::FloatRect getLeftBound() {
 		return leftBound;
@@ -200,146 +316,205 @@ public:
 #pragma endregion
 
 #pragma region Animations
-// Animations are meant to be each created once and restarted when played
-class Animation {
-protected:
-	sfClockAtHome startTime;
-	float duration;
+// Parameters of one running effect. Geometry is worked out from these every frame,
+// so an effect is a few numbers in a pool instead of an object with its own clock and drawables
+struct Effect {
+	int kind; // TEXTEFFECT, DEATHEFFECT, FLASHEFFECT, or PARTICLEEFFECT
+	float start; // Frame timestamp the effect started at, in seconds
+	float duration, endDuration; // Active time, then fade or hold time before the effect is removed
+	sf::Vector2f position; // Top left of the area the effect covers
+	int data; // Text slot, board row, or particle seed
 
-public:
-	Animation() {
-		duration = 0;
-	}
-	// Draws the animation to the window
-	virtual void update(sf::RenderWindow& window) = 0;
-	virtual ~Animation() {};
-	// Turns on animation
-	virtual void restart() = 0;
-	// Return true if animation has expired
-	virtual bool isOver() {
-		return startTime.getTimeSeconds() > duration;
+	// Seconds since the effect started
+	float getElapsed(float now) const {
+		return now - start;
 	}
-};
-
-// Text that fades after a set duration
-class FadeText : public Animation {
-	float fadeDuration; // In seconds
-	sf::Text text; // Text to display. Properties are created using setText when constructed.
-	sf::Color textColor;
-public:
-	FadeText(sf::Text text, float duration, float fadeDuration) {
-		this->text = text;
-		this->duration = duration;
-		this->fadeDuration = fadeDuration;
-		startTime.restart();
-		textColor = text.getFillColor();
-		textColor.a = 0; // This disables the animation when constructed
-		this->text.setFillColor(textColor);
-	}
-	// Draws the animation to the window
-	void update(sf::RenderWindow& window) {
-		float elapsedTime = startTime.getElapsedTime().asSeconds();
-		if (elapsedTime > duration + fadeDuration)
-			return; // Returns nothing if animation is past duration
-		if (elapsedTime > duration && textColor.a > 0) { // Begin fading
-			textColor.a = ((1 - (elapsedTime - duration) / fadeDuration) * 255);
-			text.setFillColor(textColor);
-		}
-		window.draw(text);
-	}
-	// Turns on animation
-	void restart() {
-		startTime.restart();
-		textColor.a = 255;
-		text.setFillColor(textColor);
-	}
-	// Change the text to display
-	void setString(string str) {
-		text.setString(str);
+	bool isOver(float now) const {
+		return getElapsed(now) > duration + endDuration;
 	}
 };
 
-// Class to display a player's death screen. Made from an empty board of tiles
-class DeathAnimation : public Animation {
-	float endDuration; // Delay at the end of animation
-	vector<vector<Tile>> board;
+// Fixed pool of effects for one board. Every effect is evaluated against the same frame timestamp
+// and board effects write their geometry into the board's batch. An empty pool costs nothing per frame
+class EffectSystem {
+	Effect effects[MAXEFFECTS];
+	int count;
+	sf::FloatRect tileTexRect; // Block tile for the death fill
+
+	// Cheap repeatable noise in [0, 1) so particles need no stored state
+	static float noise(int seed, int index) {
+		unsigned int h = (unsigned int)seed * 374761393u + (unsigned int)index * 668265263u;
+		h = (h ^ (h >> 13)) * 1274126177u;
+		return ((h ^ (h >> 16)) & 0xFFFF) / 65536.0f;
+	}
+	// Number of rows filled from the bottom by a death fill
+	static int getDeathRows(const Effect& effect, float elapsed) {
+		int rows = 0;
+		for (int i = 0; i < NUMROWS; i++)
+			if (elapsed / effect.duration * NUMROWS >= i - 1)
+				rows = i + 1;
+		return rows;
+	}
 public:
-	DeathAnimation() {
-		endDuration = 0;
-	};
-	DeathAnimation(sf::Vector2f gamePos, float duration, float endDuration, sf::Texture& blockTexture) {
-		this->duration = duration;
-		this->endDuration = endDuration;
-		startTime.restart();
-		// Generate board
-		for (int i = 0; i < REALNUMROWS; i++) {
-			vector<Tile> row;
-			for (int j = 0; j < NUMCOLS; j++) {
-				Tile tile(blockTexture, gamePos.x + j * TILESIZE, gamePos.y + (i - 2) * TILESIZE);
-				tile.setBlock(true, GRAY);
-				row.push_back(tile);
+	EffectSystem() {
+		count = 0;
+	}
+	EffectSystem(const TextureAtlas& atlas) : EffectSystem() {
+		tileTexRect = sf::FloatRect(atlas.getTileRect());
+	}
+	// Start an effect. Restarts a running effect of the same kind and data instead of stacking it,
+	// and replaces the oldest effect if the pool is full
+	void play(int kind, float start, float duration, float endDuration, sf::Vector2f position = ORIGIN, int data = 0) {
+		int slot = count;
+		for (int i = 0; i < count; i++)
+			if (effects[i].kind == kind && effects[i].data == data) {
+				slot = i;
+				break;
 			}
-			board.push_back(row);
+		if (slot == MAXEFFECTS) {
+			slot = 0;
+			for (int i = 1; i < count; i++)
+				if (effects[i].start < effects[slot].start)
+					slot = i;
+		}
+		else if (slot == count)
+			count++;
+		effects[slot] = { kind, start, duration, endDuration, position, data };
+	}
+	// Drop finished effects. Order is not kept
+	void update(float now) {
+		for (int i = 0; i < count;) {
+			if (effects[i].isOver(now))
+				effects[i] = effects[--count];
+			else
+				i++;
 		}
 	}
-	// Draws the animation to the window
-	void update(sf::RenderWindow& window) {
-		// Does not execute if animation duration is over
-		if (startTime.getTimeSeconds() > duration + endDuration)
-			return;
-		for (int i = 0; i < NUMROWS; i++)
-			if (startTime.getTimeSeconds() / duration * NUMROWS >= i - 1)
-				for (int j = 0; j < NUMCOLS; j++)
-					window.draw(board[REALNUMROWS - i - 1][j]);
+	// Remove every effect
+	void clear() {
+		count = 0;
 	}
-	// Turns on animation
-	void restart() {
-		startTime.restart();
+	// Return true if an effect of a kind is still running as of the last update
+	bool isPlaying(int kind) const {
+		for (int i = 0; i < count; i++)
+			if (effects[i].kind == kind)
+				return true;
+		return false;
 	}
-	// Return true if animation has expired
-	virtual bool isOver() {
-		return startTime.getTimeSeconds() > duration + endDuration;
+	int getCount() const {
+		return count;
+	}
+	// Opacity of a text slot from 0 to 1. Text stays opaque for its duration then fades out
+	float getTextAlpha(int slot, float now) const {
+		for (int i = 0; i < count; i++) {
+			const Effect& effect = effects[i];
+			if (effect.kind != TEXTEFFECT || effect.data != slot || effect.isOver(now))
+				continue;
+			float elapsed = effect.getElapsed(now);
+			if (elapsed <= effect.duration)
+				return 1;
+			return 1 - (elapsed - effect.duration) / effect.endDuration;
+		}
+		return 0;
+	}
+	// Add the geometry of every board effect to a batch. Text effects are drawn by the owner
+	void addToBatch(VertexBatch& batch, float now) const {
+		for (int i = 0; i < count; i++) {
+			const Effect& effect = effects[i];
+			float elapsed = effect.getElapsed(now);
+			if (effect.isOver(now))
+				continue;
+			switch (effect.kind)
+			{
+			case DEATHEFFECT: { // Fills the board with gray tiles from the bottom up
+				int rows = getDeathRows(effect, elapsed);
+				for (int row = REALNUMROWS - 1; row >= REALNUMROWS - rows; row--)
+					for (int col = 0; col < NUMCOLS; col++) {
+						// Same placement as board tiles
+						sf::FloatRect dest(effect.position.x + col * TILESIZE + 1, effect.position.y + (row - 2) * TILESIZE + 1, tileTexRect.width, tileTexRect.height);
+						batch.addQuad(sf::Transform::Identity, dest, tileTexRect, GRAY);
+					}
+				break;
+			}
+			case FLASHEFFECT: { // Cleared row fading from white
+				sf::Color color = WHITE;
+				color.a = (1 - elapsed / effect.duration) * 200;
+				batch.addSolidQuad({ effect.position.x, effect.position.y, GAMEWIDTH, TILESIZE }, color);
+				break;
+			}
+			case PARTICLEEFFECT: { // Sparks thrown up from a cleared row and pulled back down
+				sf::Color color = WHITE;
+				color.a = (1 - elapsed / effect.duration) * 255;
+				for (int j = 0; j < PARTICLECOUNT; j++) {
+					float x = effect.position.x + noise(effect.data, j * 3) * GAMEWIDTH;
+					float y = effect.position.y + TILESIZE / 2.0f;
+					float speedX = (noise(effect.data, j * 3 + 1) - 0.5f) * PARTICLESPEED;
+					float speedY = -noise(effect.data, j * 3 + 2) * PARTICLESPEED;
+					x += speedX * elapsed;
+					y += speedY * elapsed + PARTICLEGRAVITY * elapsed * elapsed / 2;
+					batch.addSolidQuad({ x - PARTICLESIZE / 2, y - PARTICLESIZE / 2, PARTICLESIZE, PARTICLESIZE }, color);
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
 	}
 };
 #pragma endregion
 
 // Class to display garbage bin. Actual mechanism is in Mechanisms.h
-class GarbageStack : public sf::Drawable {
-	vector<sf::RectangleShape> stack;
+// Segment quads are built once. Updates only recolor the segments whose shade changed
+class GarbageStack {
+	static const int SEGMENTVERTICES = 20;
+	vector<sf::Vertex> vertices; // Five quads per segment: fill, then top, bottom, left, and right outline
+	int shades[NUMROWS]; // Red level of each segment's fill. -1 if the segment is empty
 
-	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
-		for (int i = 0; i < stack.size(); i++) {
-			target.draw(stack[i], states);
-		}
+	// Set the fill and outline colors of a segment's quads
+	void setSegmentColors(int segment, const sf::Color& fill, const sf::Color& outline) {
+		sf::Vertex* quads = &vertices[segment * SEGMENTVERTICES];
+		for (int i = 0; i < SEGMENTVERTICES; i++)
+			quads[i].color = i < 4 ? fill : outline;
 	}
 public:
 	GarbageStack() {};
 	// Construct a stack of rectangles at position relative to gamePos
-	GarbageStack(sf::Vector2f gamePos) {
+	GarbageStack(sf::Vector2f gamePos, const TextureAtlas& atlas) {
+		sf::Vector2f texel = atlas.getWhiteTexel();
+		auto addQuad = [this, texel](float left, float top, float width, float height) {
+			vertices.push_back(sf::Vertex({ left, top }, WHITE, texel));
+			vertices.push_back(sf::Vertex({ left + width, top }, WHITE, texel));
+			vertices.push_back(sf::Vertex({ left + width, top + height }, WHITE, texel));
+			vertices.push_back(sf::Vertex({ left, top + height }, WHITE, texel));
+		};
+		const float width = TILESIZE / 2.0f, height = TILESIZE - 1, t = 1; // t is the outline thickness
 		for (int i = 0; i < NUMROWS; i++) {
-			sf::RectangleShape rec({ TILESIZE / 2.0f, TILESIZE - 1 });
-			rec.setPosition(gamePos.x - TILESIZE / 2.0f, gamePos.y + GAMEHEIGHT - (i + 1) * TILESIZE + LINEWIDTH + 1);
-			rec.setOutlineColor(WHITE);
-			rec.setOutlineThickness(1);
-			stack.push_back(rec);
+			float left = gamePos.x - TILESIZE / 2.0f, top = gamePos.y + GAMEHEIGHT - (i + 1) * TILESIZE + LINEWIDTH + 1;
+			addQuad(left, top, width, height);
+			addQuad(left - t, top - t, width + t * 2, t);
+			addQuad(left - t, top + height, width + t * 2, t);
+			addQuad(left - t, top, t, height);
+			addQuad(left + width, top, t, height);
+			shades[i] = -1;
+			setSegmentColors(i, BLACK, WHITE);
 		}
 	}
-	// Update stack visuals based on a vector of garbage timers
-	void updateStack(vector<float> vec) {
-		for (int i = 0; i < 20; i++)
-		{
-			// (255 * vec[i] + 255) / 2 sets the red value to 127-255 based on timer progress
-			if (vec.size() > i) {
-				stack[i].setFillColor(sf::Color((255 * vec[i] + 255) / 2, 0, 0));
-				if (stack[i].getFillColor() == RED)
-					stack[i].setOutlineColor(RED);
-				else
-					stack[i].setOutlineColor(WHITE);
-			}
-			else {
-				stack[i].setFillColor(BLACK);
-				stack[i].setOutlineColor(WHITE);
-			}
+	// Add stack quads to a batch with the rest of the board
+	void addToBatch(VertexBatch& batch) const {
+		batch.addVertices(vertices.data(), vertices.size(), ORIGIN);
+	}
+	// Update stack visuals from the timer progress of each garbage line, front first
+	void updateStack(const float* progress, int count) {
+		for (int i = 0; i < NUMROWS; i++) {
+			int shade = i < count ? getGarbageShade(progress[i]) : -1;
+			if (shade == shades[i])
+				continue;
+			shades[i] = shade;
+			if (shade < 0)
+				setSegmentColors(i, BLACK, WHITE);
+			else
+				setSegmentColors(i, sf::Color(shade, 0, 0), shade == 255 ? RED : WHITE);
 		}
 	}
 };
@@ -347,7 +522,7 @@ public:
 // Class for a text that can be navigated and clicked
 class ClickableMenu : public sf::Drawable {
 	vector<SfTextAtHome> texts;
-	sf::CircleShape cursor; // Takes in a shape as the cursor. Must preset attributes.
+	sf::Sprite cursor; // Takes in an atlas sprite as the cursor. Must preset attributes.
 	int cursorPos;
 
 	// Draw all menu components
@@ -360,7 +535,7 @@ public:
 	ClickableMenu() {
 		cursorPos = 0;
 	}
-	ClickableMenu(sf::Font& font, sf::Color color, vector<string>& menuText, int textSize, sf::Vector2f startPos, int spacing, sf::CircleShape cursor) {
+	ClickableMenu(sf::Font& font, sf::Color color, vector<string>& menuText, int textSize, sf::Vector2f startPos, int spacing, sf::Sprite cursor) {
 		for (int i = 0; i < menuText.size(); i++)
 			texts.push_back(SfTextAtHome(font, color, menuText[i], textSize, { startPos.x, startPos.y + spacing * i }));
 		this->cursor = cursor;
@@ -439,6 +614,9 @@ public:
 	bool checkClick(int mouseX, int mouseY) {
 		return button.contains(mouseX, mouseY);
 	}
+	sf::FloatRect getBounds() const {
+		return getUnion(button.getGlobalBounds(), text.getGlobalBounds());
+	}
 	void setFillColor(const sf::Color& color) {
 		button.setFillColor(color);
 	}
@@ -458,6 +636,8 @@ struct OptionSelector : public sf::Drawable {
 	virtual void setIndex(int index) = 0;
 	// Move all sprites
 	virtual void move(float offsetX, float offsetY) = 0;
+	// Area currently covered by the selector's sprites
+	virtual sf::FloatRect getBounds() = 0;
 
 	// React to mouse movement, click, and release. 
 	// Returns whether a successful action is performed
@@ -481,7 +661,8 @@ class BarSlider : public OptionSelector
 	// Sprites to draw
 	SfRectangleAtHome bar;
 	SfTextAtHome valueText;
-	SfCircleAtHome cursor;
+	sf::Sprite cursor;
+	const TextureAtlas* atlas;
 
 	// Data to handle
 	int minVal, maxVal;
@@ -494,7 +675,8 @@ class BarSlider : public OptionSelector
 		target.draw(cursor);
 	}
 public:
-	BarSlider(float length, int minVal, int maxVal, sf::Font& font) {
+	BarSlider(float length, int minVal, int maxVal, sf::Font& font, const TextureAtlas& atlas) {
+		this->atlas = &atlas;
 		this->minVal = minVal;
 		this->maxVal = maxVal;
 
@@ -503,8 +685,9 @@ public:
 		valueText = SfTextAtHome(font, WHITE, "0", MENUTEXTSIZE, { length + 50, 0}, true, false, true);
 
 		// Create circle cursor
-		cursor = SfCircleAtHome(WHITE, BAR_CURSOR_RADIUS, { 0, 0 }, true, BLACK, 1);
+		cursor = atlas.getCursorSprite(BAR_CURSOR_RADIUS);
 		cursorIndex = 0;
+		cursorPressed = false;
 	}
 	// Returns the value at the cursor
 	int getValue() {
@@ -517,7 +700,7 @@ public:
 
 		sf::FloatRect barPos = bar.getGlobalBounds();
 		// Collision detections extends two cursor radii out both sides
-		if (xPosition > barPos.left - cursor.getRadius() * 2 && xPosition < barPos.left + barPos.width + cursor.getRadius() * 2) {
+		if (xPosition > barPos.left - BAR_CURSOR_RADIUS * 2 && xPosition < barPos.left + barPos.width + BAR_CURSOR_RADIUS * 2) {
 			// Make sure position is within bounds
 			xPosition = max(barPos.left, xPosition);
 			xPosition = min(barPos.left + barPos.width, xPosition);
@@ -533,21 +716,22 @@ public:
 		if (val == cursorPressed) // Do nothing if variable does not need to be changed
 			return false;
 		cursorPressed = val;
-		// Visual indicator that a cursor has been clicked
+		// Visual indicator that a cursor has been clicked. Sprite is centered so it grows in place
 		if (val) {
-			cursor.setRadius(BAR_CURSOR_RADIUS + BAR_CURSOR_GROWTH);
-			cursor.move(-BAR_CURSOR_GROWTH, -BAR_CURSOR_GROWTH);
+			atlas->setCursorRadius(cursor, BAR_CURSOR_RADIUS + BAR_CURSOR_GROWTH);
 			return true;
 		}
 		else {
-			cursor.setRadius(BAR_CURSOR_RADIUS);
-			cursor.move(BAR_CURSOR_GROWTH, BAR_CURSOR_GROWTH);
+			atlas->setCursorRadius(cursor, BAR_CURSOR_RADIUS);
 			return false;
 		}
 	}
 	sf::FloatRect getCursorBounds() {
 		return cursor.getGlobalBounds();
 	}
+	sf::FloatRect getBounds() {
+		return getUnion(getUnion(bar.getGlobalBounds(), valueText.getGlobalBounds()), cursor.getGlobalBounds());
+	}
 	// Move all sprites
 	void move(float offsetX, float offsetY) {
 		bar.move(offsetX, offsetY);
@@ -599,7 +783,8 @@ class IncrementalSlider : public OptionSelector
 	SfRectangleAtHome bar;
 	vector<SfRectangleAtHome> nodes;
 	vector<SfTextAtHome> valuesText;
-	SfCircleAtHome cursor;
+	sf::Sprite cursor;
+	const TextureAtlas* atlas;
 
 	// Data to handle
 	vector<string> values;
@@ -616,7 +801,8 @@ class IncrementalSlider : public OptionSelector
 		target.draw(cursor);
 	}
 public:
-	IncrementalSlider(float length, vector<string> values, sf::Font& font) {
+	IncrementalSlider(float length, vector<string> values, sf::Font& font, const TextureAtlas& atlas) {
+		this->atlas = &atlas;
 		nodeCount = values.size();
 		this->values = values;
 
@@ -630,7 +816,9 @@ public:
 		}
 
 		// Create circle cursor
-		cursor = SfCircleAtHome(WHITE, BAR_CURSOR_RADIUS, { 0, 0 }, true, BLACK, 1);
+		cursor = atlas.getCursorSprite(BAR_CURSOR_RADIUS);
+		cursorIndex = 0;
+		cursorPressed = false;
 	}
 	// Returns the value at the cursor
 	int getValue() {
@@ -655,21 +843,25 @@ public:
 		if (val == cursorPressed) // Do nothing if variable does not need to be changed
 			return false;
 		cursorPressed = val;
-		// Visual indicator that a cursor has been clicked
+		// Visual indicator that a cursor has been clicked. Sprite is centered so it grows in place
 		if (val) {
-			cursor.setRadius(BAR_CURSOR_RADIUS + BAR_CURSOR_GROWTH);
-			cursor.move(-BAR_CURSOR_GROWTH, -BAR_CURSOR_GROWTH);
+			atlas->setCursorRadius(cursor, BAR_CURSOR_RADIUS + BAR_CURSOR_GROWTH);
 			return true;
 		}
 		else {
-			cursor.setRadius(BAR_CURSOR_RADIUS);
-			cursor.move(BAR_CURSOR_GROWTH, BAR_CURSOR_GROWTH);
+			atlas->setCursorRadius(cursor, BAR_CURSOR_RADIUS);
 			return false;
 		}
 	}
 	sf::FloatRect getCursorBounds() {
 		return cursor.getGlobalBounds();
 	}
+	sf::FloatRect getBounds() {
+		sf::FloatRect bounds = getUnion(bar.getGlobalBounds(), cursor.getGlobalBounds());
+		for (int i = 0; i < nodeCount; i++)
+			bounds = getUnion(getUnion(bounds, nodes[i].getGlobalBounds()), valuesText[i].getGlobalBounds());
+		return bounds;
+	}
 	// Move all sprites
 	void move(float offsetX, float offsetY) {
 		bar.move(offsetX, offsetY);
@@ -752,6 +944,9 @@ public:
 		switchBase.move(offsetX, offsetY);
 		switchCover.move(offsetX, offsetY);
 	}
+	virtual sf::FloatRect getBounds() {
+		return getUnion(switchBase.getBounds(), switchCover.getGlobalBounds());
+	}
 	// Process clicking the button
 	bool clickButton(int mouseX, int mouseY) {
 		if (switchBase.checkClick(mouseX, mouseY))
@@ -832,6 +1027,9 @@ public:
 		rect.move(offsetX, offsetY);
 		text.move(offsetX, offsetY);
 	}
+	sf::FloatRect getBounds() {
+		return getUnion(rect.getGlobalBounds(), text.getGlobalBounds());
+	}
 	void updateString(string str) {
 		text.setString(str);
 		text.alignCenter();
@@ -910,6 +1108,10 @@ public:
 		return cursorIndex;
 	}
 	void setIndex(int index) {
+		if (index < 0 || index >= nodes.size()) {
+			cout << "Error, invalid index for bullet list.\n";
+			throw ConfigError();
+		}
 		ghostCursor.setRadius(0); // Hides ghost cursor
 		cursorIndex = index;
 		cursor.setPosition(nodes[index].getPosition());
@@ -924,6 +1126,14 @@ public:
 			text.move(offsetX, offsetY);
 		cursor.move(offsetX, offsetY);
 	}
+	sf::FloatRect getBounds() {
+		sf::FloatRect bounds = cursor.getGlobalBounds();
+		for (int i = 0; i < nodeCount; i++)
+			bounds = getUnion(getUnion(bounds, nodes[i].getGlobalBounds()), valuesText[i].getGlobalBounds());
+		if (ghostCursor.getRadius() > 0)
+			bounds = getUnion(bounds, ghostCursor.getGlobalBounds());
+		return bounds;
+	}
 	bool onMouseMove(int mouseX, int mouseY) {
 		// Show ghost cursor
 		ghostCursor.setRadius(0); // Hides ghost cursor
@@ -963,10 +1173,10 @@ class PauseScreen : public sf::Drawable {
 		target.draw(menu, states);
 	}
 public:
-	PauseScreen(sf::Vector2f gamePos, vector<string>& menuText, sf::Font& font) {
+	PauseScreen(sf::Vector2f gamePos, vector<string>& menuText, sf::Font& font, const TextureAtlas& atlas) {
 		texts.push_back(SfTextAtHome(font, WHITE, "PAUSED", 40, { GAMEXPOS + GAMEWIDTH / 2, GAMEYPOS + GAMEWIDTH / 3 }, true, false, true));
 
-		sf::CircleShape cursor = sf::CircleShape(15.f, 3); // Triangle shaped cursor
+		sf::Sprite cursor = atlas.getTriangleSprite(15.f); // Triangle shaped cursor
 		cursor.rotate(90.f);
 		menu = ClickableMenu(font, WHITE, menuText, MENUTEXTSIZE, { gamePos.x + GAMEWIDTH / 4, gamePos.y + GAMEWIDTH * 2 / 3 }, MENUSPACING, cursor);
 	}
@@ -0,0 +1,124 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
+#include "Mechanisms.h"
+#include "Profiler.h"
+#include "Input.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Decides when a frame needs to be drawn. Static screens are only redrawn after an input event
+// or a screen change, and the loop drops to a low wake rate once nothing has changed for a while.
+class FrameScheduler {
+	sf::Clock frameClock; // Time since the previous frame ended
+	sf::Clock idleClock; // Time since the last change
+	sf::Clock runClock; // Time since the game started. Source of frame timestamps
+	float frameTime; // Timestamp shared by everything drawn this frame
+	float eventTime; // Input time the last event was polled
+	bool focused; // Window has keyboard focus
+	bool dirty; // Something changed since the last drawn frame
+	bool drawing; // Current frame is being drawn
+	int lastScreen; // Screen state of the previous frame
+	int renderMode; // RENDERCAPPED, RENDERVSYNC, or RENDERUNCAPPED
+	bool renderModeChanged; // Applied to the window at the end of the next frame
+	InputQueue* input; // Receives key events for the simulation. Null until set
+public:
+	FrameScheduler() {
+		dirty = true;
+		drawing = false;
+		lastScreen = -1;
+		frameTime = 0;
+		eventTime = 0;
+		focused = true;
+		renderMode = RENDERCAPPED;
+		renderModeChanged = true;
+		input = nullptr;
+	}
+	void setInput(InputQueue* input) {
+		this->input = input;
+	}
+	// Take the timestamp for this frame. Called once per loop before anything is animated
+	float stampFrame() {
+		frameTime = runClock.getElapsedTime().asSeconds();
+		return frameTime;
+	}
+	float getFrameTime() {
+		return frameTime;
+	}
+	// Input time the last event was polled
+	float getEventTime() {
+		return eventTime;
+	}
+	bool hasFocus() {
+		return focused;
+	}
+	// Request a redraw on the next frame
+	void markDirty() {
+		dirty = true;
+	}
+	// Poll a window event and stamp it. Any event counts as a change. Profiler hotkeys are seen here on every screen.
+	// Game keys are passed to the simulation only when no KeyListener runs. SFML events carry no time,
+	// so those keys are stamped when the loop polls them and their auto repeat lines up with frames
+	bool pollEvent(sf::RenderWindow& window, sf::Event& event) {
+		if (!window.pollEvent(event))
+			return false;
+		eventTime = getInputTime();
+		if (event.type == sf::Event::LostFocus)
+			focused = false;
+		else if (event.type == sf::Event::GainedFocus)
+			focused = true;
+		profiler.handleEvent(event);
+		if (input)
+			input->onEvent(event, eventTime);
+		dirty = true;
+		return true;
+	}
+	// Called once per loop after input is handled. Animating screens change on their own and are always drawn.
+	// Returns true if the frame should be cleared and drawn
+	bool beginFrame(int currentScreen, bool animating) {
+		if (currentScreen != lastScreen) {
+			dirty = true;
+			lastScreen = currentScreen;
+		}
+		drawing = dirty || animating;
+		dirty = false;
+		if (drawing)
+			idleClock.restart();
+		return drawing;
+	}
+	// Set how drawn frames are paced. Takes effect at the end of the current frame
+	void setRenderMode(int mode) {
+		if (mode == renderMode)
+			return;
+		renderMode = mode;
+		renderModeChanged = true;
+	}
+	int getRenderMode() {
+		return renderMode;
+	}
+	// Show the frame if it was drawn. Otherwise sleep for the rest of the frame,
+	// or longer if the screen has been idle
+	void endFrame(sf::RenderWindow& window) {
+		if (renderModeChanged) {
+			window.setVerticalSyncEnabled(renderMode == RENDERVSYNC);
+			window.setFramerateLimit(renderMode == RENDERCAPPED ? FPS : 0);
+			renderModeChanged = false;
+		}
+		if (drawing) {
+			PROFILE_ZONE(PROFILERDISPLAY);
+			window.display(); // Frame pacing is handled by the window
+		}
+		else {
+			bool idle = idleClock.getElapsedTime().asSeconds() >= IDLEDELAY;
+			sf::Time target = sf::seconds(1.0f / (idle ? IDLEFPS : FPS));
+			sf::Time elapsed = frameClock.getElapsedTime();
+			if (elapsed < target)
+				sf::sleep(target - elapsed);
+		}
+		frameClock.restart();
+	}
+	bool isDrawing() {
+		return drawing;
+	}
+};
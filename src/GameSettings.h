@@ -1,8 +1,16 @@
 #pragma once
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <memory>
 #include <SFML/Graphics.hpp>
 #include "TetrisConstants.h"
 #include "Screen.h"
+#include "FrameScheduler.h"
+#include "Assets.h"
 
 using namespace std;
 using namespace TetrisVariables;
@@ -12,6 +20,121 @@ using namespace TetrisVariables;
 map<sf::Keyboard::Key, string> keyStrings;
 
 // Contains the setting data structures
+// Buckets rectangles into a uniform grid so a point is only tested against the items near it
+class HitGrid {
+    int columns, rows;
+    vector<vector<int>> cells; // Indices of the items overlapping each cell
+    vector<int> empty; // Returned for points outside the grid
+public:
+    HitGrid() : HitGrid(WIDTH, HEIGHT) {}
+    HitGrid(int width, int height) {
+        columns = (width + HITGRIDCELLSIZE - 1) / HITGRIDCELLSIZE;
+        rows = (height + HITGRIDCELLSIZE - 1) / HITGRIDCELLSIZE;
+        cells.resize(columns * rows);
+    }
+    // Add an item to every cell its bounds overlap
+    void insert(int item, const sf::FloatRect& bounds) {
+        int left = max(0, (int)floor(bounds.left / HITGRIDCELLSIZE));
+        int top = max(0, (int)floor(bounds.top / HITGRIDCELLSIZE));
+        int right = min(columns - 1, (int)floor((bounds.left + bounds.width) / HITGRIDCELLSIZE));
+        int bottom = min(rows - 1, (int)floor((bounds.top + bounds.height) / HITGRIDCELLSIZE));
+        for (int row = top; row <= bottom; row++)
+            for (int col = left; col <= right; col++)
+                cells[row * columns + col].push_back(item);
+    }
+    // Items that may contain a point, in the order they were added
+    const vector<int>& query(float x, float y) const {
+        int col = floor(x / HITGRIDCELLSIZE), row = floor(y / HITGRIDCELLSIZE);
+        if (col < 0 || row < 0 || col >= columns || row >= rows)
+            return empty;
+        return cells[row * columns + col];
+    }
+};
+
+// Reads and writes the config file. Values are kept in DEFAULTSETTINGS order
+class ConfigFile {
+public:
+    // Parse a config into values. Keys that are missing, unknown, or not numbers keep their default.
+    // Files from before the version line are read by position. Returns false if the file should be rewritten
+    static bool parse(istream& in, vector<int>& values) {
+        values = DEFAULTSETTINGS;
+        bool current = true;
+        vector<bool> found(CONFIGKEYS.size(), false);
+        string line;
+        int version = 0, position = 0;
+        while (getline(in, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty() || line[0] == '#')
+                continue;
+            size_t split = line.find('=');
+            try {
+                if (split == string::npos) { // Positional value from an unversioned file
+                    if (version == 0 && position < values.size())
+                        values[position] = stoi(line), found[position] = true;
+                    position++;
+                    current = false;
+                    continue;
+                }
+                string key = line.substr(0, split);
+                int value = stoi(line.substr(split + 1));
+                if (key == "version") {
+                    version = value;
+                    continue;
+                }
+                auto iter = find(CONFIGKEYS.begin(), CONFIGKEYS.end(), key);
+                if (iter == CONFIGKEYS.end()) {
+                    cout << "Unknown config key " << key << ". Ignoring\n";
+                    current = false;
+                    continue;
+                }
+                values[iter - CONFIGKEYS.begin()] = value;
+                found[iter - CONFIGKEYS.begin()] = true;
+            }
+            catch (exception err) {
+                cout << "Unreadable config line \"" << line << "\". Ignoring\n";
+                current = false;
+            }
+        }
+        for (int i = 0; i < found.size(); i++)
+            if (!found[i]) {
+                if (version > 0)
+                    cout << "Config key " << CONFIGKEYS[i] << " is missing. Using default\n";
+                current = false;
+            }
+        return current && version == CONFIGVERSION;
+    }
+    // Read a config file. Returns false if it should be rewritten, including when it does not exist
+    static bool read(const string& path, vector<int>& values) {
+        ifstream inFile(path);
+        if (!inFile.is_open()) {
+            cout << "Config file does not exist. Creating default file.\n";
+            values = DEFAULTSETTINGS;
+            return false;
+        }
+        return parse(inFile, values);
+    }
+    // Write to a temporary file and rename it over the config, so a crash leaves the old file or the new one
+    static void write(const string& path, const vector<int>& values) {
+        string tempPath = path + ".tmp";
+        ofstream outFile(tempPath);
+        if (!outFile.is_open()) {
+            cout << "Failed to write file";
+            throw exception();
+        }
+        outFile << "version=" << CONFIGVERSION << "\n";
+        for (int i = 0; i < values.size() && i < CONFIGKEYS.size(); i++)
+            outFile << CONFIGKEYS[i] << "=" << values[i] << "\n";
+        outFile.close();
+        error_code error;
+        if (outFile.fail() || (filesystem::rename(tempPath, path, error), error)) {
+            filesystem::remove(tempPath, error);
+            cout << "Failed to write file";
+            throw exception();
+        }
+    }
+};
+
 // A single tab containing configurable settings
 class SettingsTab : public sf::Drawable {
     SfRectangleAtHome tabRect;
@@ -26,7 +149,17 @@ class SettingsTab : public sf::Drawable {
     int settingCount;
 
     vector<sf::Text> extraText; // Any additional text to draw
-    vector<sf::Sprite> extraSprites; // Any additional sprites to draw
+    VertexBatch extraSprites; // Any additional atlas sprites to draw. Built once and drawn in one call
+
+    HitGrid hitGrid; // Selectors bucketed by position for mouse events
+    int hovered; // Selector that took the last mouse move, or -1
+    int dragged; // Selector that took the last click until the mouse is released, or -1
+
+    // Contents are drawn once into a render texture. Afterwards only the regions of changed selectors are redrawn
+    mutable unique_ptr<sf::RenderTexture> cache;
+    mutable bool rebuildCache;
+    mutable vector<bool> dirty; // Selectors changed since the cache was drawn
+    mutable vector<sf::FloatRect> paintedBounds; // Selector bounds as last drawn into the cache
 
     SoundManager* soundFX;
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
@@ -36,20 +169,90 @@ class SettingsTab : public sf::Drawable {
 
         // Draw contents if current tab is selected
         if (tabSelected) {
-            for (int i = 0; i < settingCount; i++)
-            {
-                target.draw(settingsTexts[i], states);
-                target.draw(*settingSelectors[i], states);
+            updateCache();
+            states.blendMode = BLENDPREMULTIPLIED;
+            target.draw(sf::Sprite(cache->getTexture()), states);
+        }
+    }
+    // Draw everything in the tab that overlaps a region
+    void drawContents(sf::RenderTarget& target, const sf::FloatRect& region) const {
+        for (const SfTextAtHome& text : settingsTexts)
+            if (text.getGlobalBounds().intersects(region))
+                target.draw(text);
+        for (const sf::Text& text : extraText)
+            if (text.getGlobalBounds().intersects(region))
+                target.draw(text);
+        if (extraSprites.getBounds().intersects(region))
+            target.draw(extraSprites);
+        for (int i = 0; i < settingCount; i++)
+            if (paintedBounds[i].intersects(region))
+                target.draw(*settingSelectors[i]);
+    }
+    // Erase a region of the cache and redraw what overlaps it. The view clips drawing to the region
+    void repaint(sf::FloatRect region) const {
+        sf::Vector2u size = cache->getSize();
+        float left = max(0.0f, floor(region.left)), top = max(0.0f, floor(region.top));
+        float right = min((float)size.x, ceil(region.left + region.width)), bottom = min((float)size.y, ceil(region.top + region.height));
+        if (right <= left || bottom <= top)
+            return;
+        region = sf::FloatRect(left, top, right - left, bottom - top);
+
+        sf::View view(region);
+        view.setViewport(sf::FloatRect(left / size.x, top / size.y, region.width / size.x, region.height / size.y));
+        cache->setView(view);
+        sf::RectangleShape eraser({ region.width, region.height });
+        eraser.setPosition(left, top);
+        eraser.setFillColor(sf::Color::Transparent);
+        cache->draw(eraser, sf::BlendNone);
+        drawContents(*cache, region);
+        cache->setView(cache->getDefaultView());
+    }
+    // Bring the cache up to date before it is drawn
+    void updateCache() const {
+        if (!cache) {
+            cache = make_unique<sf::RenderTexture>();
+            cache->create(WIDTH, HEIGHT);
+            rebuildCache = true;
+        }
+        if (rebuildCache) {
+            for (int i = 0; i < settingCount; i++) {
+                paintedBounds[i] = settingSelectors[i]->getBounds();
+                dirty[i] = false;
             }
-            for (int i = 0; i < extraText.size(); i++)
-                target.draw(extraText[i], states);
-            for (int i = 0; i < extraSprites.size(); i++)
-                target.draw(extraSprites[i], states);
+            cache->clear(sf::Color::Transparent);
+            drawContents(*cache, sf::FloatRect(0, 0, WIDTH, HEIGHT));
+            rebuildCache = false;
         }
-
+        else {
+            // Update every bound first so overlapping selectors are drawn where they are now
+            vector<sf::FloatRect> regions;
+            for (int i = 0; i < settingCount; i++)
+                if (dirty[i]) {
+                    sf::FloatRect bounds = settingSelectors[i]->getBounds();
+                    regions.push_back(getInflated(getUnion(paintedBounds[i], bounds), 2)); // Margin for antialiased edges
+                    paintedBounds[i] = bounds;
+                    dirty[i] = false;
+                }
+            if (regions.empty())
+                return;
+            for (const sf::FloatRect& region : regions)
+                repaint(region);
+        }
+        cache->display();
+    }
+    void markDirty(int selectorIndex) {
+        dirty[selectorIndex] = true;
+    }
+    int getSelectorIndex(OptionSelector* selector) {
+        return find(settingSelectors.begin(), settingSelectors.end(), selector) - settingSelectors.begin();
+    }
+    // Key recorder at a selector index, or null if the selector is not one
+    KeyRecorder* getKeybind(int selectorIndex) {
+        auto iter = find(keybinds.begin(), keybinds.end(), settingSelectors[selectorIndex]);
+        return iter == keybinds.end() ? nullptr : *iter;
     }
 public:
-    SettingsTab(sf::Font& font, string name, int index, SoundManager* soundFX) {
+    SettingsTab(sf::Font& font, string name, int index, SoundManager* soundFX, const TextureAtlas& atlas) {
         // Rect origin is set at 0, 0 and text origin is centered
         tabRect = SfRectangleAtHome(GRAY, { 0, 0 }, { 0, 0 }, false, BLACK, 2);
         tabText = SfTextAtHome(font, WHITE, name, MENUTEXTSIZE, { 0, 0 }, true, false, true, true);
@@ -57,7 +260,16 @@ public:
         tabSelected = false;
         settingCount = 0;
         this->soundFX = soundFX;
-    }
+        extraSprites = VertexBatch(atlas);
+        hovered = -1;
+        dragged = -1;
+        rebuildCache = true;
+    }
+    // Tabs own their selectors and cache, so they can be moved but not copied
+    SettingsTab(const SettingsTab&) = delete;
+    SettingsTab& operator=(const SettingsTab&) = delete;
+    SettingsTab(SettingsTab&&) = default;
+    SettingsTab& operator=(SettingsTab&&) = default;
     ~SettingsTab() {
         for (OptionSelector* sel : settingSelectors)
             delete sel;
@@ -108,15 +320,25 @@ public:
         settingsTexts.push_back(SfTextAtHome(font, WHITE, text, MENUTEXTSIZE, textPosition));
         settingSelectors.push_back(selector);
         selector->move(selectorPosition.x, selectorPosition.y);
+        hitGrid.insert(settingCount, getInflated(selector->getBounds(), HITMARGIN));
+        dirty.push_back(false);
+        paintedBounds.push_back(selector->getBounds());
         settingCount++;
+        rebuildCache = true;
     }
     // Add additional text to draw
     void addExtraText(sf::Text text) {
         extraText.push_back(text);
+        rebuildCache = true;
+    }
+    // Add additional sprites to draw. Sprite must use the atlas texture
+    void addExtraSprite(const sf::Sprite& sprite) {
+        extraSprites.addSprite(sprite);
+        rebuildCache = true;
     }
-    // Add additional sprites to draw
-    void addExtraSprite(sf::Sprite sprite) {
-        extraSprites.push_back(sprite);
+    // Redraw all contents on the next draw. Used after selectors are changed from outside the tab
+    void invalidate() {
+        rebuildCache = true;
     }
     // Add a setting option while storing a keybind for extra operations
     void addKeybind(string text, sf::Vector2f textPosition, sf::Vector2f selectorPosition, sf::Font& font) {
@@ -128,6 +350,7 @@ public:
     void readKeys(sf::Keyboard::Key key) {
         for (KeyRecorder* keyRec : keybinds) {
             if (keyRec->getSelected() && keyRec->readKey(key)) {
+                markDirty(getSelectorIndex(keyRec));
                 soundFX->play(LIGHTTAP);
                 break;
             }
@@ -137,30 +360,67 @@ public:
     vector<KeyRecorder*>& getKeybinds() {
         return keybinds;
     }
-    void setKey(int index, sf::Keyboard::Key key) {
+    // Returns false if the key cannot be bound
+    bool setKey(int index, sf::Keyboard::Key key) {
         keybinds[index]->setSelect(true);
-        keybinds[index]->readKey(key);
+        bool bound = keybinds[index]->readKey(key);
+        keybinds[index]->setSelect(false);
+        markDirty(getSelectorIndex(keybinds[index]));
+        return bound;
     }
 
     OptionSelector& operator[](int index) {
         return *settingSelectors[index];
     }
-    // Check all mechanisms on mouse click position
+    // Check mechanisms near the mouse position. A selector being dragged gets every move until release
     void onMouseMove(int mouseX, int mouseY) {
-        for (OptionSelector* selector : settingSelectors)
-            if (selector->onMouseMove(mouseX, mouseY))
+        if (dragged >= 0) {
+            if (settingSelectors[dragged]->onMouseMove(mouseX, mouseY))
+                markDirty(dragged);
+            return;
+        }
+        int target = -1;
+        for (int i : hitGrid.query(mouseX, mouseY))
+            if (settingSelectors[i]->onMouseMove(mouseX, mouseY)) {
+                target = i;
                 break; // Break after a successful action. Skips the need to check everything
+            }
+        // Let the selector the mouse left clear its hover visuals
+        if (hovered >= 0 && hovered != target) {
+            settingSelectors[hovered]->onMouseMove(mouseX, mouseY);
+            markDirty(hovered);
+        }
+        if (target >= 0)
+            markDirty(target);
+        hovered = target;
     }
     void onMouseClick(int mouseX, int mouseY) {
-        for (OptionSelector* selector : settingSelectors)
-            if (selector->onMouseClick(mouseX, mouseY)) {
+        // Clicking anywhere deselects a keybind waiting for a key
+        for (KeyRecorder* keyRec : keybinds)
+            if (keyRec->getSelected()) {
+                keyRec->onMouseClick(mouseX, mouseY);
+                markDirty(getSelectorIndex(keyRec));
+            }
+        for (int i : hitGrid.query(mouseX, mouseY)) {
+            // Key recorders change selection on click without reporting it
+            KeyRecorder* keyRec = getKeybind(i);
+            bool wasSelected = keyRec && keyRec->getSelected();
+            if (settingSelectors[i]->onMouseClick(mouseX, mouseY)) {
+                markDirty(i);
                 soundFX->play(LIGHTTAP);
+                dragged = i;
                 break; // Since no sprites overlap, this saves the need to check all bounds;
             }
+            if (keyRec && keyRec->getSelected() != wasSelected)
+                markDirty(i);
+        }
     }
     void onMouseRelease() {
-        for (OptionSelector* selector : settingSelectors)
-            selector->onMouseRelease();
+        if (dragged >= 0) {
+            settingSelectors[dragged]->onMouseRelease();
+            markDirty(dragged);
+            dragged = -1;
+        }
     }
 };
 
@@ -175,13 +435,16 @@ class SettingsMenu : public sf::Drawable {
     ClickableButton saveButton; // Save and continue
     SoundManager* soundFX;
     sf::Font* font;
+    TextureAtlas* atlas;
     int* currentScreen; // Pointer to current screen to return to the menu screen 
 
     // Setting data
     vector<Screen*> screens; // Game screens the setting will apply to
     vector<KeyDAS*> dasSets; // Control profiles to modify
-    sf::Music* bgm;
+    BackgroundMusic* bgm;
+    FrameScheduler* frames;
     vector<int> configValues; // A saved copy of config values. Only updates when reading or writing the config file
+    bool configStale; // The file differs from configValues, such as when it was missing or had invalid keys
     string fileName;
 
 
@@ -196,14 +459,16 @@ class SettingsMenu : public sf::Drawable {
 
 
 public:
-    SettingsMenu(vector<Screen*> screens, vector<KeyDAS*> dasSets, SoundManager* soundFX, sf::Font& font, sf::Music* bgm, int* currentScreen) {
+    SettingsMenu(vector<Screen*> screens, vector<KeyDAS*> dasSets, SoundManager* soundFX, sf::Font& font, TextureAtlas& atlas, BackgroundMusic* bgm, FrameScheduler* frames, int* currentScreen) {
         tabCount = 0;
         currentTabIndex = 0;
         this->screens = screens;
         this->dasSets = dasSets;
         this->soundFX = soundFX;
         this->font = &font;
+        this->atlas = &atlas;
         this->bgm = bgm;
+        this->frames = frames;
         this->currentScreen = currentScreen;
         fileName = CONFIGFILEPATH;
         // Initialize keyStrings if empty
@@ -234,17 +499,17 @@ public:
         tab1Text = { "Starting Speed","Next Piece Count", "Piece Holding", "Ghost Piece", "Auto Shift Delay", "Auto Shift Speed",
             "Piece RNG", "Rotation Style", "Garbage Timer", "Garbage Multiplier", "Garbage RNG" };
 
-        tab1Selectors.push_back(new IncrementalSlider(270, { "Easy", "Normal", "Hard" }, font));
-        tab1Selectors.push_back(new IncrementalSlider(270, { "0", "1", "2", "3", "4", "5", "6" }, font));
+        tab1Selectors.push_back(new IncrementalSlider(270, { "Easy", "Normal", "Hard" }, font, atlas));
+        tab1Selectors.push_back(new IncrementalSlider(270, { "0", "1", "2", "3", "4", "5", "6" }, font, atlas));
         tab1Selectors.push_back(new OnOffSwitch(font));
         tab1Selectors.push_back(new OnOffSwitch(font));
-        tab1Selectors.push_back(new IncrementalSlider(270, { "Long", "Normal", "Short", "Instant" }, font));
-        tab1Selectors.push_back(new IncrementalSlider(270, { "Slow", "Normal", "Fast", "Instant" }, font));
-        tab1Selectors.push_back(new IncrementalSlider(150, { "Random", "7-Bag" }, font));
-        tab1Selectors.push_back(new IncrementalSlider(150, { "Classic", "Modern" }, font));
-        tab1Selectors.push_back(new IncrementalSlider(270, { "5s", "3s", "1s", "Instant" }, font));
-        tab1Selectors.push_back(new IncrementalSlider(270, { "0.5x", "1x", "1.5x" }, font));
-        tab1Selectors.push_back(new IncrementalSlider(270, { "Easy", "Normal", "Hard" }, font));
+        tab1Selectors.push_back(new IncrementalSlider(270, { "Long", "Normal", "Short", "Instant" }, font, atlas));
+        tab1Selectors.push_back(new IncrementalSlider(270, { "Slow", "Normal", "Fast", "Instant" }, font, atlas));
+        tab1Selectors.push_back(new IncrementalSlider(150, { "Random", "7-Bag" }, font, atlas));
+        tab1Selectors.push_back(new IncrementalSlider(150, { "Classic", "Modern" }, font, atlas));
+        tab1Selectors.push_back(new IncrementalSlider(270, { "5s", "3s", "1s", "Instant" }, font, atlas));
+        tab1Selectors.push_back(new IncrementalSlider(270, { "0.5x", "1x", "1.5x" }, font, atlas));
+        tab1Selectors.push_back(new IncrementalSlider(270, { "Easy", "Normal", "Hard" }, font, atlas));
 
         // Add settings to tab 1
         for (int i = 0; i < tab1Selectors.size(); i++)
@@ -267,7 +532,7 @@ public:
             tabs[1].addExtraText(SfTextAtHome(font, WHITE, playersText[i], MENUTEXTSIZE, sf::Vector2f(SETTINGXPOS + SELECTORRIGHTSPACING / 1.5f * (i + 1), SETTINGYPOS), true, false, true));
 
         // Set contents for tab 3
-        vector<string> tab3Text{ "Block Colors", "BGM Volume", "SFX Volume" };
+        vector<string> tab3Text{ "Block Colors", "BGM Volume", "SFX Volume", "Frame Rate", "Music Loading" };
         vector<sf::Vector2f> tab3TextPositions{ {SETTINGXPOS, SETTINGYPOS}};
         vector<OptionSelector*> tab3Selectors{ new BulletListSelector(SETTINGSPACING, {"1", "2", "3"}, font)};
         vector<sf::Vector2f> tab3SelectorPositions = { {SETTINGXPOS, SETTINGYPOS + SETTINGSPACING} };
@@ -275,9 +540,17 @@ public:
         // Add two volume sliders
         for (int i = 0; i < 2; i++){
             tab3TextPositions.push_back({ SETTINGXPOS, SETTINGYPOS + SETTINGSPACING * (i * 2 + 4)});
-            tab3Selectors.push_back(new BarSlider(270, 0, 100, font));
+            tab3Selectors.push_back(new BarSlider(270, 0, 100, font, atlas));
             tab3SelectorPositions.push_back({ SETTINGXPOS, SETTINGYPOS + SETTINGSPACING * (i * 2 + 5) });
         }
+        // Frame rate selector
+        tab3TextPositions.push_back({ SETTINGXPOS, SETTINGYPOS + SETTINGSPACING * 8 });
+        tab3Selectors.push_back(new IncrementalSlider(270, { "60 FPS", "Display", "Uncapped" }, font, atlas));
+        tab3SelectorPositions.push_back({ SETTINGXPOS + SELECTORRIGHTSPACING, SETTINGYPOS + SETTINGSPACING * 8 });
+        // Music decode strategy. Preloading trades memory for no decoding while playing
+        tab3TextPositions.push_back({ SETTINGXPOS, SETTINGYPOS + SETTINGSPACING * 9 });
+        tab3Selectors.push_back(new IncrementalSlider(150, { "Stream", "Preload" }, font, atlas));
+        tab3SelectorPositions.push_back({ SETTINGXPOS + SELECTORRIGHTSPACING, SETTINGYPOS + SETTINGSPACING * 9 });
 
         // Load sprites to display color pallete options
         for (int i = 0; i < PIECECOLORSETS.size(); i++)
@@ -288,7 +561,7 @@ public:
                 tetrominos[j]->setColor(PIECECOLORSETS[i][j]);
             }
             for (int k = 0; k < tetrominoCount; k++) { // Display queue
-                vector<sf::Sprite> pieceSprite = tetrominos[k]->getPieceSprite(screens[0]->getBlockTexture(),
+                vector<sf::Sprite> pieceSprite = tetrominos[k]->getPieceSprite(atlas,
                     130 + k * 5 * TILESIZE * PALLETEPIECESCALE,
                     130 + i * 3 * TILESIZE * PALLETEPIECESCALE, PALLETEPIECESCALE);
                 for (sf::Sprite& sprite : pieceSprite)
@@ -304,13 +577,14 @@ public:
         for (int i = 0; i < tab3Selectors.size(); i++)
             tabs[2].addSetting(tab3Text[i], tab3TextPositions[i], tab3Selectors[i], tab3SelectorPositions[i], font);
 
-        // Read settings file
+        // Read settings file. It is only written back if it was missing or had to fall back
         readConfigFile();
         resetConfig();
         updateAllSettings();
+        writeConfigFile();
     }
     void addTab(sf::Font& font, string name) {
-        tabs.push_back(SettingsTab(font, name, tabCount++, soundFX));
+        tabs.emplace_back(font, name, tabCount++, soundFX, *atlas);
         alignTabs();
     }
     // Align tab positions across top of screen based on number of tabs
@@ -380,110 +654,133 @@ public:
     }
     // Reset settings to saved configValues (false) or defaultValues (true)
     // This function does not change gameplay variables
+    // A value a selector rejects falls back to its default on its own
     void resetConfig(bool defaultValues = false) {
         const vector<int>& config = (defaultValues) ? DEFAULTSETTINGS : configValues;
-        try {
-            int index = 0;
-            int tab1Size = tabs[0].getSelectors().size(); // Index to separate tabs
-            int tab2Size = tabs[1].getSelectors().size();
-            int tab3Size = tabs[2].getSelectors().size();
-            for (int i = 0; i < tab1Size; i++) // First tab
-                tabs[0][i].setIndex(config.at(index++));
-            for (int i = 0; i < tab2Size; i++) { // Second tab
-                tabs[1].setKey(i, sf::Keyboard::Key(config.at(index++)));
+        int index = 0;
+        for (int tab = 0; tab < 3; tab++)
+            for (int i = 0; i < tabs[tab].getSelectors().size(); i++, index++) {
+                if (tab == 1) { // Keybinds
+                    if (!tabs[1].setKey(i, sf::Keyboard::Key(config[index]))) {
+                        cout << "Invalid value for " << CONFIGKEYS[index] << ". Using default\n";
+                        tabs[1].setKey(i, sf::Keyboard::Key(DEFAULTSETTINGS[index]));
+                        configStale = true;
+                    }
+                    continue;
+                }
+                try {
+                    tabs[tab][i].setIndex(config[index]);
+                }
+                catch (ConfigError err) {
+                    cout << "Invalid value for " << CONFIGKEYS[index] << ". Using default\n";
+                    tabs[tab][i].setIndex(DEFAULTSETTINGS[index]);
+                    configStale = true;
+                }
             }
-            for (int i = 0; i < tab3Size; i++) // Third tab 
-                tabs[2][i].setIndex(config.at(index++));
-        }
-        catch (out_of_range err) {
-            cout << "config out of range. Restoring to default\n";
-            cout << err.what();
-            resetConfig(true);
-        }
-        writeConfigFile();
+        for (SettingsTab& tab : tabs)
+            tab.invalidate();
     }
-    // Read config file and save the vector of integers
+    // Read config file into configValues. Missing or invalid keys get their default
     void readConfigFile() {
-        ifstream inFile(fileName);
-        try {
-            if (!inFile.is_open())
-                throw ConfigError();
-            configValues.clear();
-            string line;
-            while (getline(inFile, line))
-                configValues.push_back(stoi(line));
-        }
-        catch (ConfigError err) {
-            cout << "Config file does not exist. Creating default file.\n";
-            resetConfig(true);
-            writeConfigFile();
-        }
-        catch (exception err) {
-            cout << "Config file reading error. Restoring to defaults.\n";
-            resetConfig(true);
-            writeConfigFile();
-        }
-        inFile.close();
+        configStale = !ConfigFile::read(fileName, configValues);
     }
 
-    // Write setting menu contents to a file
+    // Write setting menu contents to the config file. Skipped when nothing changed since it was read or written
     void writeConfigFile() {
-        configValues = getValues();
-        ofstream outFile(fileName);
-        if (!outFile.is_open()) {
-            cout << "Failed to write file";
-            throw exception();
-        }
-        for (int val : configValues)
-            outFile << to_string(val) << endl;
-        outFile.close();
+        vector<int> values = getValues();
+        if (values == configValues && !configStale)
+            return;
+        ConfigFile::write(fileName, values);
+        configValues = values;
+        configStale = false;
     }
 
     // Convert settings menu contents to gameplay variables
-    void updateAllSettings() {
+    // Only settings marked in changed are applied, in config order. All of them are applied if it is empty
+    void updateAllSettings(const vector<bool>& changed = {}) {
+        int tab2Start = tabs[0].getSelectors().size(); // Config indices where the later tabs start
+        int tab3Start = tab2Start + tabs[1].getSelectors().size();
+        auto isChanged = [&changed](int index) { return changed.empty() || changed[index]; };
         vector<int> settings = tabs[0].getValues();
         // Update game screens
         for (Screen* screen : screens) {
             // Starting speed. Will not take effect in sandbox mode
-            screen->setStartingGravity(GRAVITYSPEEDS[settings[0]]);
-            screen->setNextPieceCount(settings[1]); // Next piece count
-            screen->setHoldEnabled(settings[2]);	// Piece holding
-            screen->setGhostPieceEnabled(settings[3]); // Ghost piece
-            screen->setBagEnabled(settings[6]); // 7-bag
-            screen->setSRS(settings[7]); // Rotation style
-            screen->setGarbageTimer(GARBAGETIMERS[settings[8]]); // Garbage timer
-            screen->setGarbageMultiplier(GARBAGEMULTIPLIERS[settings[9]]); // Garbage multiplier
-            screen->setGarbRepeatProbability(GARBAGEREPEATPROBABILITIES[settings[10]]); // Garbage repeat probability
-
-            // Update hold and queue display
-            screen->getScreenRects()[1].setSize(sf::Vector2f{ TILESIZE * 4.0f * settings[2], TILESIZE * 4.0f * settings[2] });
-            screen->getScreenRects()[2].setSize(sf::Vector2f{ TILESIZE * 4.0f * settings[1] / settings[1], GAMEHEIGHT / 9.0f * settings[1] });
-
+            if (isChanged(0))
+                screen->setStartingGravity(GRAVITYSPEEDS[settings[0]]);
+            if (isChanged(1))
+                screen->setNextPieceCount(settings[1]); // Next piece count
+            if (isChanged(2))
+                screen->setHoldEnabled(settings[2]);	// Piece holding
+            if (isChanged(3))
+                screen->setGhostPieceEnabled(settings[3]); // Ghost piece
+            if (isChanged(6))
+                screen->setBagEnabled(settings[6]); // 7-bag
+            if (isChanged(7))
+                screen->setSRS(settings[7]); // Rotation style
+            if (isChanged(8))
+                screen->setGarbageTimer(GARBAGETIMERS[settings[8]]); // Garbage timer
+            if (isChanged(9))
+                screen->setGarbageMultiplier(GARBAGEMULTIPLIERS[settings[9]]); // Garbage multiplier
+            if (isChanged(10))
+                screen->setGarbRepeatProbability(GARBAGEREPEATPROBABILITIES[settings[10]]); // Garbage repeat probability
+            // Hold and queue boxes are resized by the renderer from the next snapshot
         }
 
         // Update das responsiveness
         vector<KeySet*> keySets;
         for (KeyDAS* keyDas : dasSets) {
-            keyDas->setStartDelay(DASDELAYVALUES[settings[4]]); // DAS delay
-            keyDas->setHoldDelay(DASSPEEDVALUES[settings[5]]); // DAS speed
+            if (isChanged(4))
+                keyDas->setStartDelay(DASDELAYVALUES[settings[4]]); // DAS delay
+            if (isChanged(5))
+                keyDas->setHoldDelay(DASSPEEDVALUES[settings[5]]); // DAS speed
             keySets.push_back(keyDas->getKeySet());
         }
 
         // Update keybind configurations from setting tab entries
         std::vector<KeyRecorder*> keybinds = tabs[1].getKeybinds();
         for (int i = 0; i < keybinds.size(); i++) // Update keybind controls
-            *keySets[i / 7]->getSet()[i % 7] = *keybinds[i]->getKey();
+            if (isChanged(tab2Start + i))
+                *keySets[i / 7]->getSet()[i % 7] = *keybinds[i]->getKey();
 
         // Tab 3 values
         settings = tabs[2].getValues();
 
         // Update color pallete
-        for (Screen* screen : screens)
-            screen->setColorPallete(settings[0]);
-
-        // Update volume settings
-        bgm->setVolume(BGMVOLUME * settings[1] / 100);
-        soundFX->setVolume(SFXVOLUME * settings[2] / 100);
-
+        if (isChanged(tab3Start))
+            for (Screen* screen : screens)
+                screen->setColorPallete(settings[0]);
+
+        // Update music loading and volume settings
+        if (isChanged(tab3Start + 4))
+            bgm->setMode(settings[4]);
+        if (isChanged(tab3Start + 1))
+            bgm->setVolume(BGMVOLUME * settings[1] / 100);
+        if (isChanged(tab3Start + 2))
+            soundFX->setVolume(SFXVOLUME * settings[2] / 100);
+
+        // Update frame pacing
+        if (isChanged(tab3Start + 3))
+            frames->setRenderMode(settings[3]);
+
+    }
+    // Apply a config that was edited outside the game. Only settings that differ from the saved ones are applied,
+    // and the menu shows the new values in place of any unsaved changes. Returns true if a keybind changed
+    bool reloadConfig(const vector<int>& values) {
+        if (values == configValues)
+            return false;
+        int tab2Start = tabs[0].getSelectors().size();
+        int tab3Start = tab2Start + tabs[1].getSelectors().size();
+        vector<bool> changed(values.size());
+        bool keysChanged = false;
+        for (int i = 0; i < values.size(); i++) {
+            changed[i] = i >= configValues.size() || values[i] != configValues[i];
+            if (changed[i] && i >= tab2Start && i < tab3Start)
+                keysChanged = true;
+        }
+        configValues = values;
+        resetConfig();
+        updateAllSettings(changed);
+        cout << "Config file reloaded\n";
+        return keysChanged;
     }
 };
\ No newline at end of file
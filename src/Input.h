@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <SFML/Window.hpp>
+#include "TetrisConstants.h"
+#include "Mechanisms.h"
+#include "Latency.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// A key going down or up, stamped with the input time it was seen
+struct KeyEvent {
+	sf::Keyboard::Key key;
+	bool pressed;
+	float time;
+	int sequence; // Press number followed by the latency harness. 0 if not followed
+};
+
+// Fixed size queue from one writer thread to one reader thread. Push and pop never lock or wait.
+// Push fails when the queue is full, so the writer can try again later
+template <typename T, int N>
+class SpscQueue {
+	T items[N];
+	atomic<int> head; // Next item to pop. Written by the reader
+	atomic<int> tail; // Next slot to push. Written by the writer
+public:
+	SpscQueue() : head(0), tail(0) {}
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+	bool push(const T& item) {
+		int slot = tail.load(memory_order_relaxed), next = (slot + 1) % N;
+		if (next == head.load(memory_order_acquire))
+			return false;
+		items[slot] = item;
+		tail.store(next, memory_order_release);
+		return true;
+	}
+	bool pop(T& item) {
+		int slot = head.load(memory_order_relaxed);
+		if (slot == tail.load(memory_order_acquire))
+			return false;
+		item = items[slot];
+		head.store((slot + 1) % N, memory_order_release);
+		return true;
+	}
+};
+
+// Key changes queued for the simulation thread. Changes come from a KeyListener thread as they arrive where one runs,
+// and from the window's events otherwise. Each is stamped when it is seen, so auto repeat is worked out from
+// when keys changed rather than from when a tick runs. Only keys of the current players are queued, and only while the window has focus.
+// The listener and the main thread push under writeLock, and the simulation thread pops without locking
+class InputQueue {
+	SpscQueue<KeyEvent, INPUTQUEUESIZE> queue;
+	mutex writeLock; // Guards everything below. Makes the two writers one producer
+	KeyboardState watched; // Keys to queue
+	KeyboardState queued; // State the queued changes add up to
+	bool active, focused;
+	bool listened; // A KeyListener feeds the keys, so key events from the window are ignored
+
+	// Queue a change unless it is already queued. A change that does not fit is dropped along with its key's state,
+	// so the next event for that key is still queued correctly
+	void queueChange(sf::Keyboard::Key key, bool pressed, float time) {
+		if (pressed != queued.isPressed(key) && queue.push({ key, pressed, time, pressed ? latency.nextInput() : 0 }))
+			queued.set(key, pressed);
+	}
+	// Queue every difference between a state and the queued state
+	void queueChanges(const KeyboardState& state, float time) {
+		bitset<sf::Keyboard::KeyCount> changed = state.getDifferences(queued);
+		for (int i = 0; changed.any() && i < sf::Keyboard::KeyCount; i++)
+			if (changed[i]) {
+				queueChange(sf::Keyboard::Key(i), state.isPressed(sf::Keyboard::Key(i)), time);
+				changed[i] = false;
+			}
+	}
+	bool isListening() const {
+		return active && (focused || latency.isInjecting());
+	}
+public:
+	InputQueue() {
+		active = false;
+		focused = true;
+		listened = false;
+	}
+	// Queue a key going down or up if it is watched. Key repeats change nothing
+	void onKey(sf::Keyboard::Key key, bool pressed, float time) {
+		lock_guard<mutex> guard(writeLock);
+		if (isListening() && !latency.isInjecting() && watched.isPressed(key))
+			queueChange(key, pressed, time);
+	}
+	// Queue a key event from the window unless a KeyListener already reports the keys
+	void onEvent(const sf::Event& event, float time) {
+		if ((event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) && !listened)
+			onKey(event.key.code, event.type == sf::Event::KeyPressed, time);
+	}
+	// Called by a KeyListener once it receives key events
+	void setListened(bool value) {
+		lock_guard<mutex> guard(writeLock);
+		listened = value;
+	}
+	// Called once per loop. Releases every key while not listening, since keys let go without focus send no event.
+	// While the latency harness runs, its script replaces the keyboard
+	void update(float now) {
+		lock_guard<mutex> guard(writeLock);
+		KeyboardState state;
+		if (isListening() && latency.isInjecting())
+			latency.getInjectedState(state, now);
+		else if (isListening())
+			return;
+		queueChanges(state, now);
+	}
+	// Set the keys to queue. Keys that are no longer watched are released
+	void watch(const vector<sf::Keyboard::Key>& keys) {
+		lock_guard<mutex> guard(writeLock);
+		watched.clear();
+		for (sf::Keyboard::Key key : keys)
+			watched.set(key, true);
+		KeyboardState kept; // Held keys that stay watched
+		for (sf::Keyboard::Key key : keys)
+			kept.set(key, queued.isPressed(key));
+		queueChanges(kept, getInputTime());
+	}
+	void setActive(bool value) {
+		lock_guard<mutex> guard(writeLock);
+		active = value;
+	}
+	void setFocused(bool value) {
+		lock_guard<mutex> guard(writeLock);
+		focused = value;
+	}
+	// Take the oldest queued change. Only called from the simulation thread
+	bool pop(KeyEvent& keyEvent) {
+		return queue.pop(keyEvent);
+	}
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include <SFML/Window.hpp>
+#include "TetrisConstants.h"
+#include "Mechanisms.h"
+#include "Input.h"
+#ifdef __linux__
+#define Screen XScreen // Xlib's Screen would clash with the game's
+#include <X11/Xlib.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+#undef Screen
+#include <poll.h>
+#endif
+
+using namespace std;
+using namespace TetrisVariables;
+
+#ifdef __linux__
+// Reads the window's key events on its own thread, so game keys reach the simulation while the main thread
+// is drawing or waiting on display. Opens a second X connection, which only this thread uses, and asks for
+// key events on the game window. X sends key events to every client that asks, so SFML still gets its own.
+// Each change is stamped when it arrives. Without X, keys keep coming from the window's events
+class KeyListener {
+	Display* display;
+	InputQueue* input;
+	atomic<bool> running;
+	thread worker;
+
+	static sf::Keyboard::Key translateKey(KeySym symbol) {
+		if (symbol >= XK_a && symbol <= XK_z)
+			return sf::Keyboard::Key(sf::Keyboard::A + (symbol - XK_a));
+		if (symbol >= XK_0 && symbol <= XK_9)
+			return sf::Keyboard::Key(sf::Keyboard::Num0 + (symbol - XK_0));
+		if (symbol >= XK_KP_0 && symbol <= XK_KP_9)
+			return sf::Keyboard::Key(sf::Keyboard::Numpad0 + (symbol - XK_KP_0));
+		if (symbol >= XK_F1 && symbol <= XK_F15)
+			return sf::Keyboard::Key(sf::Keyboard::F1 + (symbol - XK_F1));
+		switch (symbol) {
+		case XK_Escape: return sf::Keyboard::Escape;
+		case XK_Control_L: return sf::Keyboard::LControl;
+		case XK_Shift_L: return sf::Keyboard::LShift;
+		case XK_Alt_L: return sf::Keyboard::LAlt;
+		case XK_Super_L: return sf::Keyboard::LSystem;
+		case XK_Control_R: return sf::Keyboard::RControl;
+		case XK_Shift_R: return sf::Keyboard::RShift;
+		case XK_Alt_R: return sf::Keyboard::RAlt;
+		case XK_Super_R: return sf::Keyboard::RSystem;
+		case XK_Menu: return sf::Keyboard::Menu;
+		case XK_bracketleft: return sf::Keyboard::LBracket;
+		case XK_bracketright: return sf::Keyboard::RBracket;
+		case XK_semicolon: return sf::Keyboard::Semicolon;
+		case XK_comma: return sf::Keyboard::Comma;
+		case XK_period: return sf::Keyboard::Period;
+		case XK_apostrophe: return sf::Keyboard::Quote;
+		case XK_slash: return sf::Keyboard::Slash;
+		case XK_backslash: return sf::Keyboard::Backslash;
+		case XK_grave: return sf::Keyboard::Tilde;
+		case XK_equal: return sf::Keyboard::Equal;
+		case XK_minus: return sf::Keyboard::Hyphen;
+		case XK_space: return sf::Keyboard::Space;
+		case XK_Return: return sf::Keyboard::Enter;
+		case XK_BackSpace: return sf::Keyboard::Backspace;
+		case XK_Tab: return sf::Keyboard::Tab;
+		case XK_Prior: return sf::Keyboard::PageUp;
+		case XK_Next: return sf::Keyboard::PageDown;
+		case XK_End: return sf::Keyboard::End;
+		case XK_Home: return sf::Keyboard::Home;
+		case XK_Insert: return sf::Keyboard::Insert;
+		case XK_Delete: return sf::Keyboard::Delete;
+		case XK_KP_Add: return sf::Keyboard::Add;
+		case XK_KP_Subtract: return sf::Keyboard::Subtract;
+		case XK_KP_Multiply: return sf::Keyboard::Multiply;
+		case XK_KP_Divide: return sf::Keyboard::Divide;
+		case XK_Left: return sf::Keyboard::Left;
+		case XK_Right: return sf::Keyboard::Right;
+		case XK_Up: return sf::Keyboard::Up;
+		case XK_Down: return sf::Keyboard::Down;
+		case XK_Pause: return sf::Keyboard::Pause;
+		default: return sf::Keyboard::Unknown;
+		}
+	}
+	// Keypad digits are only the first symbol with num lock off, so they are looked up on the shifted level
+	sf::Keyboard::Key getKey(unsigned int keycode) {
+		KeySym shifted = XkbKeycodeToKeysym(display, keycode, 0, 1);
+		if (shifted >= XK_KP_0 && shifted <= XK_KP_9)
+			return translateKey(shifted);
+		return translateKey(XkbKeycodeToKeysym(display, keycode, 0, 0));
+	}
+	void run() {
+		pollfd poller = { ConnectionNumber(display), POLLIN, 0 };
+		while (running) {
+			if (!XPending(display) && poll(&poller, 1, KEYLISTENERWAKEDELAY) <= 0)
+				continue;
+			float time = getInputTime(); // Events read in one wake arrived together
+			while (XPending(display)) {
+				XEvent event;
+				XNextEvent(display, &event);
+				if (event.type == KeyPress || event.type == KeyRelease)
+					input->onKey(getKey(event.xkey.keycode), event.type == KeyPress, time);
+			}
+		}
+	}
+public:
+	KeyListener(InputQueue& input) : running(false) {
+		display = nullptr;
+		this->input = &input;
+	}
+	~KeyListener() {
+		stop();
+	}
+	// Start listening to a window's keys. Returns false if X cannot be reached, leaving keys to the window's events
+	bool start(const sf::Window& window) {
+		display = XOpenDisplay(nullptr);
+		if (!display) {
+			cout << "Key listener could not connect to X. Reading keys from window events\n";
+			return false;
+		}
+		// Held keys repeat as presses only, instead of release and press pairs
+		Bool repeatDetected = False;
+		XkbSetDetectableAutoRepeat(display, True, &repeatDetected);
+		if (!repeatDetected) {
+			cout << "Key listener cannot tell key repeats from releases. Reading keys from window events\n";
+			XCloseDisplay(display);
+			display = nullptr;
+			return false;
+		}
+		XSelectInput(display, window.getSystemHandle(), KeyPressMask | KeyReleaseMask);
+		XFlush(display);
+		input->setListened(true);
+		running = true;
+		worker = thread(&KeyListener::run, this);
+		return true;
+	}
+	void stop() {
+		if (worker.joinable()) {
+			running = false;
+			worker.join();
+			input->setListened(false);
+		}
+		if (display) {
+			XCloseDisplay(display);
+			display = nullptr;
+		}
+	}
+};
+
+// Xlib names that clash with SFML and the rest of the game
+#undef None
+#undef Bool
+#undef Status
+#undef True
+#undef False
+#undef Always
+#else
+class KeyListener {
+public:
+	KeyListener(InputQueue&) {}
+	bool start(const sf::Window&) {
+		return false;
+	}
+	void stop() {}
+};
+#endif
@@ -0,0 +1,156 @@
+#pragma once
+#include <string>
+#include <SFML/Window.hpp>
+#include "TetrisConstants.h"
+#include "Mechanisms.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Input to photon latency harness. Built only when TETRIS_LATENCY is defined (cmake -DTETRIS_LATENCY=ON).
+// Every queued key press gets a sequence number that travels with it through the simulation into the board snapshots.
+// Once a frame drawn from a snapshot that includes the press returns from display, the time since the press
+// is added to the histogram of its action. Run with --latency N to inject N presses into classic mode and exit
+// with the report, so the harness can run unattended, such as on a headless Xvfb session
+#ifdef TETRIS_LATENCY
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+class LatencyTracker {
+	struct Press {
+		int sequence, action;
+		float inputTime; // Input time of the sample that saw the press
+	};
+	mutex lock; // Presses are applied on the simulation thread and displayed on the main thread
+	deque<Press> applied; // Applied presses waiting for a displayed frame, oldest first
+	vector<float> samples[LATENCYACTIONCOUNT]; // Measured latencies in milliseconds
+	int nextSequence; // Main thread only
+
+	// Injection script. Presses cycle through these keys
+	sf::Keyboard::Key script[LATENCYSCRIPTLENGTH];
+	int scriptActions[LATENCYSCRIPTLENGTH];
+	int injectCount; // Presses to inject. 0 when not injecting
+	float injectStart; // Input time of the first injected press. Negative until injection starts
+	atomic<int> injected;
+
+	void printHistogram(const vector<float>& sorted) const {
+		int buckets[LATENCYBUCKETS] = {};
+		int largest = 0;
+		for (float sample : sorted) {
+			int bucket = min((int)sample, LATENCYBUCKETS - 1);
+			largest = max(largest, ++buckets[bucket]);
+		}
+		for (int i = 0; i < LATENCYBUCKETS; i++)
+			if (buckets[i] > 0)
+				cout << setw(4) << i << (i == LATENCYBUCKETS - 1 ? "+ ms | " : "  ms | ")
+					<< string(max(1, buckets[i] * LATENCYBARWIDTH / largest), '#') << " " << buckets[i] << "\n";
+	}
+public:
+	LatencyTracker() : injected(0) {
+		nextSequence = 0;
+		injectCount = 0;
+		injectStart = -1;
+		for (int i = 0; i < LATENCYSCRIPTLENGTH; i++)
+			script[i] = sf::Keyboard::Unknown, scriptActions[i] = LATENCYSHIFT;
+	}
+	// Reads --latency N from the command line
+	void parseArgs(int argc, char** argv) {
+		for (int i = 1; i + 1 < argc; i++)
+			if (strcmp(argv[i], "--latency") == 0)
+				injectCount = max(0, atoi(argv[i + 1]));
+	}
+	// Keys the injected presses use. Shift left and right, spin, hold, and hard drop so every action is measured
+	void setScript(KeySet* keys) {
+		sf::Keyboard::Key scriptKeys[LATENCYSCRIPTLENGTH] = { keys->getLeft(), keys->getSpinCW(), keys->getRight(), keys->getHold(), keys->getUp() };
+		int actions[LATENCYSCRIPTLENGTH] = { LATENCYSHIFT, LATENCYROTATE, LATENCYSHIFT, LATENCYHOLD, LATENCYHARDDROP };
+		for (int i = 0; i < LATENCYSCRIPTLENGTH; i++)
+			script[i] = scriptKeys[i], scriptActions[i] = actions[i];
+	}
+	bool isInjecting() const {
+		return injectCount > 0;
+	}
+	// Keys the script holds at a time. Used in place of the keyboard's events
+	void getInjectedState(KeyboardState& state, float now) {
+		if (injectStart < 0)
+			injectStart = now + LATENCYINJECTPERIOD; // Let the first frames settle
+		float elapsed = now - injectStart;
+		if (elapsed < 0)
+			return;
+		int press = elapsed / LATENCYINJECTPERIOD;
+		if (press >= injectCount)
+			return;
+		injected = press + 1;
+		if (elapsed - press * LATENCYINJECTPERIOD < LATENCYINJECTHOLD)
+			state.set(script[press % LATENCYSCRIPTLENGTH], true);
+	}
+	// True once every injected press has been injected and displayed
+	bool isFinished() {
+		lock_guard<mutex> guard(lock);
+		return isInjecting() && injected >= injectCount && applied.empty();
+	}
+	// Sequence number for a new press. Only called by input queue writers, which hold its write lock
+	int nextInput() {
+		return ++nextSequence;
+	}
+	// A press changed a board
+	void onApplied(int sequence, int action, float inputTime) {
+		lock_guard<mutex> guard(lock);
+		for (const Press& press : applied)
+			if (press.sequence == sequence) // Same key bound for both players
+				return;
+		applied.push_back({ sequence, action, inputTime });
+	}
+	// A frame drawn from boards that include every press up to a sequence has returned from display
+	void onDisplayed(int sequence, float displayTime) {
+		lock_guard<mutex> guard(lock);
+		while (!applied.empty() && applied.front().sequence <= sequence) {
+			samples[applied.front().action].push_back(displayTime - applied.front().inputTime);
+			applied.pop_front();
+		}
+	}
+	// Print count, percentiles, and a histogram for every action
+	void printReport() {
+		lock_guard<mutex> guard(lock);
+		cout << "Input to photon latency (ms)\n";
+		for (int action = 0; action < LATENCYACTIONCOUNT; action++) {
+			vector<float> sorted = samples[action];
+			cout << LATENCYACTIONNAMES[action] << ": " << sorted.size() << " presses";
+			if (sorted.empty()) {
+				cout << "\n";
+				continue;
+			}
+			sort(sorted.begin(), sorted.end());
+			cout << fixed << setprecision(2) << ", min " << sorted.front() << ", p50 " << sorted[sorted.size() / 2]
+				<< ", p99 " << sorted[min(sorted.size() - 1, (size_t)(sorted.size() * 0.99f))] << ", max " << sorted.back() << "\n";
+			printHistogram(sorted);
+		}
+	}
+};
+#else
+// Stand-in with the same interface that does nothing
+class LatencyTracker {
+public:
+	void parseArgs(int, char**) {}
+	void setScript(KeySet*) {}
+	bool isInjecting() const {
+		return false;
+	}
+	void getInjectedState(KeyboardState&, float) {}
+	bool isFinished() {
+		return false;
+	}
+	int nextInput() {
+		return 0;
+	}
+	void onApplied(int, int, float) {}
+	void onDisplayed(int, float) {}
+	void printReport() {}
+};
+#endif
+LatencyTracker latency;
@@ -1,6 +1,7 @@
 #pragma once
 #include <algorithm>
 #include <random>
+#include <bitset>
 using namespace TetrisVariables;
 
 // Modified sf::Clock for ease of use and pausing
@@ -50,46 +51,74 @@ public:
 
 };
 
-// Class to handle auto repeat / DAS
+// Shared time base for key timestamps, in milliseconds. Events are stamped with it as they arrive
+// and the simulation works out auto repeat against it
+sf::Clock inputClock;
+float getInputTime() {
+	return inputClock.getElapsedTime().asMicroseconds() / 1000.0f;
+}
+
+// Class to handle auto repeat / DAS from key timestamps. The press is one action, then once startDelay has passed
+// a repeat is owed every holdDelay. Owed actions are counted against the tick time, so they are not rounded to ticks or frames
 class KeyTimer {
-	sf::Clock startTimer, holdTimer;
 	float startDelay, holdDelay; // In milliseconds
-	bool startOn, holdOn;
+	bool held;
+	bool released; // Key went up but the press has not been settled by an update yet
+	float pressTime, releaseTime;
+	int actionsDone; // Actions already handed out for this press
+	int carried; // Actions owed by earlier presses that were released before an update
 public:
 	KeyTimer(float startDelay = 0, float holdDelay = 0) {
 		this->startDelay = startDelay;
 		this->holdDelay = holdDelay;
-		startOn = false;
-		holdOn = false;
-	}
-	// Handles action while key is pressed. Returns true if an action should be performed
-	bool onPress() {
-		if (holdOn) { // If startOn and holdOn are true, check for auto repeat
-			if (holdTimer.getElapsedTime().asMilliseconds() >= holdDelay) {
-				holdTimer.restart();
-				return true;
-			}
-			return false;
-		}
-		// If holdOn isn't true, check startOn for startTimer. This doubles as taking action on the initial press
-		if (!startOn) {
-			startOn = true;
-			startTimer.restart();
-			return true;
-		}
-		else {
-			// Starts the auto-repeated after startDelay has elapsed
-			if (startTimer.getElapsedTime().asMilliseconds() >= startDelay) {
-				holdOn = true;
-				holdTimer.restart();
-			}
-			return false;
+		held = false;
+		released = false;
+		pressTime = 0;
+		releaseTime = 0;
+		actionsDone = 0;
+		carried = 0;
+	}
+	// Key went down. Ignored while it is already held. A release not yet settled is counted up first
+	// so a tap, release, and tap between two updates still hands out both taps
+	void press(float time) {
+		if (isHeld())
+			return;
+		if (released)
+			carried += update(releaseTime);
+		held = true;
+		released = false;
+		pressTime = time;
+		actionsDone = 0;
+	}
+	// Key went up. Actions owed before the release are still handed out by the next update
+	void release(float time) {
+		if (!isHeld())
+			return;
+		released = true;
+		releaseTime = time;
+	}
+	bool isHeld() {
+		return held && !released;
+	}
+	// Returns the number of actions owed since the last update. A 0 ms repeat owes INSTANTREPEAT actions every update
+	int update(float now) {
+		int actions = carried;
+		carried = 0;
+		if (!held)
+			return actions;
+		float end = released ? min(now, releaseTime) : now;
+		int owed = 1;
+		if (end >= pressTime + startDelay) {
+			if (holdDelay <= 0)
+				owed = actionsDone + INSTANTREPEAT;
+			else
+				owed += (end - pressTime - startDelay) / holdDelay;
 		}
-	}
-	// Key is released. Reset boolean values
-	void release() {
-		holdOn = false;
-		startOn = false;
+		actions += max(0, owed - actionsDone);
+		actionsDone = max(owed, actionsDone);
+		if (released)
+			held = false;
+		return actions;
 	}
 	void setStartDelay(float val) {
 		startDelay = val;
@@ -99,6 +128,26 @@ public:
 	}
 };
 
+// Pressed state of every key, built up from key events. Reading it never queries the keyboard
+class KeyboardState {
+	bitset<sf::Keyboard::KeyCount> keys;
+public:
+	void set(sf::Keyboard::Key key, bool pressed) {
+		if (key >= 0 && key < sf::Keyboard::KeyCount)
+			keys[key] = pressed;
+	}
+	bool isPressed(sf::Keyboard::Key key) const {
+		return key >= 0 && key < sf::Keyboard::KeyCount && keys[key];
+	}
+	void clear() {
+		keys.reset();
+	}
+	// Keys pressed in one state and not the other
+	bitset<sf::Keyboard::KeyCount> getDifferences(const KeyboardState& other) const {
+		return keys ^ other.keys;
+	}
+};
+
 // Stores the controls for each player
 class KeySet {
 	sf::Keyboard::Key left;
@@ -164,6 +213,10 @@ public:
 	sf::Keyboard::Key getHold() {
 		return hold;
 	}
+	// True for keys that act once when pressed: hard drop, spins, and hold
+	bool isActionKey(sf::Keyboard::Key key) {
+		return key == up || key == spinCW || key == spinCCW || key == hold;
+	}
 	// Return a series of pointers to the keybinds
 	vector<sf::Keyboard::Key*> getSet() {
 		return { &up, &left, &down, &right, &spinCW, &spinCCW, &hold };
@@ -185,25 +238,44 @@ public:
 		this->keySet = keySet;
 	}
 
-	// Handles movement with auto-repeat (DAS). Run this for the profile that controls the current screen
+	// Handles movement with auto-repeat (DAS). Run this every tick for the profile that controls the current screen.
+	// Every move owed by now is applied in one step. Moves owed while paused are dropped
 	template <typename T> // Needs template to fix a linking issue
-	void checkKeyPress(T& screen) {
-		if (sf::Keyboard::isKeyPressed(keySet->getLeft()) && leftKey.onPress()) 
-			screen->movePiece(0);
-		else if (sf::Keyboard::isKeyPressed(keySet->getRight()) && rightKey.onPress())
-			screen->movePiece(2);
-		// The code above prioritizes the left key if both left and right are held.
-		if (sf::Keyboard::isKeyPressed(keySet->getDown()) && (downKey.onPress()))
-			screen->movePiece(1);
-	}
-	// Must be called during the KeyReleasedEvent
-	void releaseKey(sf::Keyboard::Key& event) {
-		if (event == keySet->getLeft())
-			leftKey.release();
-		else if (event == keySet->getDown())
-			downKey.release();
-		else if (event == keySet->getRight())
-			rightKey.release();
+	void update(T& screen, float now) {
+		int left = leftKey.update(now), right = rightKey.update(now), down = downKey.update(now);
+		if (screen->getPaused())
+			return;
+		if (left > 0)
+			screen->shiftPiece(0, left);
+		else if (right > 0)
+			screen->shiftPiece(2, right);
+		// The code above prioritizes the left key on ticks where both left and right move.
+		if (down > 0)
+			screen->shiftPiece(1, down);
+	}
+	// Movement action pressed or released at an input time. Other actions are ignored
+	void pressAction(int action, float time) {
+		if (KeyTimer* timer = getTimer(action))
+			timer->press(time);
+	}
+	void releaseAction(int action, float time) {
+		if (KeyTimer* timer = getTimer(action))
+			timer->release(time);
+	}
+	KeyTimer* getTimer(int action) {
+		if (action == ACTIONLEFT)
+			return &leftKey;
+		if (action == ACTIONDOWN)
+			return &downKey;
+		if (action == ACTIONRIGHT)
+			return &rightKey;
+		return nullptr;
+	}
+	// Release every key. Used when key events can be missed, such as after losing focus or changing screens
+	void releaseAll(float time) {
+		leftKey.release(time);
+		rightKey.release(time);
+		downKey.release(time);
 	}
 	// Set DAS speeds via settings
 	void setStartDelay(float val) {
@@ -261,12 +333,11 @@ public:
 			addBatch(); // Replenish queue
 		return pieceQueue[positions[playerIndex] - 1];
 	}
-	// Returns the queue of next pieces to display
-	vector<int> getNextPieces(int playerIndex, int pieceCount) {
-		vector<int> queue;
+	// Fills a queue with the next pieces to display. Reuses the queue's memory
+	void getNextPieces(int playerIndex, vector<int>& queue, int pieceCount) {
+		queue.resize(pieceCount);
 		for (int i = 0; i < pieceCount; i++)
-			queue.push_back(pieceQueue[positions[playerIndex] + i]);
-		return queue;
+			queue[i] = pieceQueue[positions[playerIndex] + i];
 	}
 };
 // A batch of garbage with a timer before it is dumped onto a board
@@ -375,76 +446,67 @@ public:
 		for (Garbage& garb : bin)
 			garb.resume();
 	}
-	// Get a textual representation of the garbage that is remaining in the bin.
-	vector<float> getBin() {
-		vector<float> vec;
+	// Write the timer progress of each line remaining in the bin, front first. Returns the number of lines written
+	int writeProgress(float* progress, int capacity) {
+		int count = 0;
 		for (Garbage& garb : bin) {
-			for (int i = 0; i < garb.getSize(); i++) {
-				vec.push_back(garb.getTime() / garb.getDuration());
-			}
+			float value = garb.getTime() / garb.getDuration();
+			for (int i = 0; i < garb.getSize() && count < capacity; i++)
+				progress[count++] = value;
 		}
-		return vec;
+		return count;
 	}
 };
 
 // Class for sound clips coming from a "soundboard" file
-class SoundEffect : public sf::Sound {
-	float startTime; // In seconds
-	float duration; // In seconds
-public:
-	SoundEffect(sf::SoundBuffer& buffer, float startTime, float duration) {
-		setBuffer(buffer);
-		this->startTime = startTime;
-		this->duration = duration;
-	}
-	void play() {
-		sf::Sound::play();
-		setPlayingOffset(sf::seconds(startTime));
-	}
-	// Check when the sound has met the duration and stop it.
-	bool checkSound() {
-		if (getPlayingOffset().asSeconds() > startTime + duration) {
-			stop();
-			return true;
-		}
-		return false;
-	}
-};
-
-// Class for managing sound effects from a single buffer and keeping checks across classes
+// Class for managing sound effects cut from a single soundboard file and shared across classes.
+// Every effect has its own buffer, so clips start at once and end on their own. Effects play on a small pool of voices,
+// so the same effect can overlap itself
 class SoundManager {
-	vector<SoundEffect> soundEffects;
-	sf::SoundBuffer buffer;
-	map<float, int> timestamps; // Maps timestamp to vector index for easier play function calls
+	sf::SoundBuffer effects[SOUNDEFFECTCOUNT];
+	sf::Sound voices[SOUNDVOICECOUNT];
+	int nextVoice; // Voice to cut off when every voice is playing
+	float volume;
 public:
-	SoundManager(string fileName) {
-		if (!buffer.loadFromFile(fileName)) {
-			cout << "Missing audio file";
-			throw exception();
+	// Cut the effects from a decoded soundboard
+	SoundManager(const sf::SoundBuffer& soundboard) {
+		// Samples are interleaved by channel, so clips are cut on whole frames
+		unsigned int channels = soundboard.getChannelCount(), sampleRate = soundboard.getSampleRate();
+		sf::Uint64 frameCount = soundboard.getSampleCount() / channels;
+		for (int i = 0; i < SOUNDEFFECTCOUNT; i++) {
+			sf::Uint64 start = min(frameCount, (sf::Uint64)(SOUNDEFFECTSTARTS[i] * sampleRate));
+			sf::Uint64 length = min(frameCount - start, (sf::Uint64)(CLIPDURATION * sampleRate));
+			if (length == 0 || !effects[i].loadFromSamples(soundboard.getSamples() + start * channels, length * channels, channels, sampleRate)) {
+				cout << "Audio file is too short";
+				throw exception();
+			}
 		}
+		nextVoice = 0;
+		volume = 100;
 	}
-	void addEffect(float startTime) {
-		timestamps.emplace(startTime, soundEffects.size());
-		soundEffects.push_back(SoundEffect(buffer, startTime, CLIPDURATION));
-	}
-	// Check when a sound has met its duration and stop it.
-	void checkTimers() {
-		for (SoundEffect& fx : soundEffects)
-			fx.checkSound();
-	}
-	SoundEffect& operator[](int index) {
-		return soundEffects[index];
-	}
-	void play(float time) {
-		soundEffects[timestamps[time]].play();
+	// Play an effect on a free voice, or on the oldest voice if none are free
+	void play(int effect) {
+		if (volume <= 0)
+			return;
+		int voice = nextVoice;
+		for (int i = 0; i < SOUNDVOICECOUNT; i++)
+			if (voices[(nextVoice + i) % SOUNDVOICECOUNT].getStatus() != sf::Sound::Playing) {
+				voice = (nextVoice + i) % SOUNDVOICECOUNT;
+				break;
+			}
+		nextVoice = (voice + 1) % SOUNDVOICECOUNT;
+		voices[voice].stop();
+		voices[voice].setBuffer(effects[effect]);
+		voices[voice].play();
 	}
 	void setVolume(float volume) {
-		for (SoundEffect& fx : soundEffects)
-			fx.setVolume(volume);
+		this->volume = volume;
+		for (sf::Sound& voice : voices)
+			voice.setVolume(volume);
 	}
 	void pauseAll() {
-		for (SoundEffect& fx : soundEffects)
-			fx.pause();
+		for (sf::Sound& voice : voices)
+			voice.pause();
 	}
 };
 
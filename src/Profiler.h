@@ -0,0 +1,181 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
+#include "Drawing.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Frame profiler. Built only when TETRIS_PROFILER is defined (cmake -DTETRIS_PROFILER=ON).
+// Zones are scoped timers placed with PROFILE_ZONE. Phases that do not fit a scope use PROFILE_BEGIN and PROFILE_END
+// on the main thread. Without the flag every call below compiles to nothing
+#ifdef TETRIS_PROFILER
+#include <atomic>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+#define PROFILE_ZONE(zone) ProfileZone profileZone(zone)
+#define PROFILE_BEGIN(zone) profiler.beginZone(zone)
+#define PROFILE_END(zone) profiler.endZone(zone)
+
+// Times a main loop phase. Phases on the simulation thread add up every tick that ran during the frame
+class Profiler {
+	sf::Clock clock; // Shared time base for every zone
+	atomic<long long> pending[PROFILERZONECOUNT]; // Microseconds spent in each zone this frame
+	long long starts[PROFILERZONECOUNT]; // Open zones from PROFILE_BEGIN. Main thread only
+	float samples[PROFILERZONECOUNT][PROFILERWINDOW]; // Rolling window of per-frame times in milliseconds
+	int sampleIndex, sampleCount;
+	long long lastFrame; // Start of the current frame in microseconds
+	bool visible, logging;
+
+	sf::Text text; // Stats table. Rebuilt a few times per second
+	sf::RectangleShape background;
+	sf::VertexArray graph; // Frame times of the window, newest on the right
+	sf::Clock refreshTimer, logTimer;
+
+	// Min, average, and 99th percentile of a zone over the window
+	void getStats(int zone, float& low, float& average, float& p99) const {
+		float sorted[PROFILERWINDOW];
+		copy(samples[zone], samples[zone] + sampleCount, sorted);
+		sort(sorted, sorted + sampleCount);
+		float total = 0;
+		for (int i = 0; i < sampleCount; i++)
+			total += sorted[i];
+		low = sorted[0];
+		average = total / sampleCount;
+		p99 = sorted[min(sampleCount - 1, (int)(sampleCount * 0.99f))];
+	}
+	// Rebuild the stats table
+	string getReport() const {
+		ostringstream report;
+		report << fixed << setprecision(2) << left << setw(10) << "ms" << setw(8) << "min" << setw(8) << "avg" << "p99\n";
+		for (int zone = 0; zone < PROFILERZONECOUNT; zone++) {
+			float low, average, p99;
+			getStats(zone, low, average, p99);
+			report << setw(10) << PROFILERZONENAMES[zone] << setw(8) << low << setw(8) << average << p99 << "\n";
+		}
+		return report.str();
+	}
+	// Rebuild the frame time graph. Each bar is one frame, scaled so the dashed target is 1 / FPS
+	void updateGraph() {
+		graph.clear();
+		const float left = 10, bottom = 10 + PROFILERGRAPHHEIGHT, scale = PROFILERGRAPHHEIGHT / (2000.0f / FPS);
+		for (int i = 0; i < sampleCount; i++) {
+			float frameTime = samples[PROFILERFRAME][(sampleIndex - sampleCount + i + PROFILERWINDOW) % PROFILERWINDOW];
+			float height = min(frameTime * scale, (float)PROFILERGRAPHHEIGHT);
+			sf::Color color = frameTime > 1000.0f / FPS ? RED : GREEN;
+			graph.append(sf::Vertex({ left + i, bottom }, color));
+			graph.append(sf::Vertex({ left + i, bottom - height }, color));
+		}
+		for (int i = 0; i < PROFILERWINDOW; i += 4) { // Target line
+			graph.append(sf::Vertex({ left + i, bottom - PROFILERGRAPHHEIGHT / 2.0f }, WHITE));
+			graph.append(sf::Vertex({ left + i + 2, bottom - PROFILERGRAPHHEIGHT / 2.0f }, WHITE));
+		}
+	}
+public:
+	Profiler() : graph(sf::Lines) {
+		for (int i = 0; i < PROFILERZONECOUNT; i++)
+			pending[i] = 0, starts[i] = 0;
+		sampleIndex = 0, sampleCount = 0;
+		lastFrame = 0;
+		visible = false, logging = false;
+		background.setFillColor(sf::Color(0, 0, 0, 190));
+		background.setPosition(5, 5);
+	}
+	void setFont(sf::Font& font) {
+		text = SfTextAtHome(font, WHITE, "", 14, { 10, 20 + PROFILERGRAPHHEIGHT }, false);
+	}
+	long long now() const {
+		return clock.getElapsedTime().asMicroseconds();
+	}
+	// Add time to a zone. Safe from any thread
+	void addTime(int zone, long long microseconds) {
+		pending[zone].fetch_add(microseconds, memory_order_relaxed);
+	}
+	void beginZone(int zone) {
+		starts[zone] = now();
+	}
+	void endZone(int zone) {
+		addTime(zone, now() - starts[zone]);
+	}
+	// F3 toggles the overlay and F4 toggles logging to the console
+	void handleEvent(const sf::Event& event) {
+		if (event.type != sf::Event::KeyPressed)
+			return;
+		if (event.key.code == sf::Keyboard::F3)
+			visible = !visible;
+		else if (event.key.code == sf::Keyboard::F4)
+			logging = !logging;
+	}
+	bool isVisible() const {
+		return visible;
+	}
+	// Close the frame's samples. Called once per loop after the frame is shown
+	void endFrame() {
+		long long frameEnd = now();
+		if (lastFrame > 0)
+			pending[PROFILERFRAME] = frameEnd - lastFrame;
+		lastFrame = frameEnd;
+		for (int zone = 0; zone < PROFILERZONECOUNT; zone++)
+			samples[zone][sampleIndex] = pending[zone].exchange(0, memory_order_relaxed) / 1000.0f;
+		sampleIndex = (sampleIndex + 1) % PROFILERWINDOW;
+		sampleCount = min(sampleCount + 1, PROFILERWINDOW);
+
+		if (logging && logTimer.getElapsedTime().asSeconds() >= 1) {
+			cout << getReport() << endl;
+			logTimer.restart();
+		}
+	}
+	// Draw the overlay in the top left of the current view
+	void draw(sf::RenderTarget& target) {
+		if (!visible || sampleCount == 0)
+			return;
+		if (refreshTimer.getElapsedTime().asSeconds() >= PROFILERREFRESH) {
+			text.setString(getReport());
+			updateGraph();
+			sf::FloatRect bounds = text.getGlobalBounds();
+			background.setSize({ max(bounds.width, (float)PROFILERWINDOW) + 10, bounds.top + bounds.height });
+			refreshTimer.restart();
+		}
+		target.draw(background);
+		target.draw(graph);
+		target.draw(text);
+	}
+};
+Profiler profiler;
+
+// Adds the time until the end of its scope to a zone
+class ProfileZone {
+	int zone;
+	long long start;
+public:
+	ProfileZone(int zone) {
+		this->zone = zone;
+		start = profiler.now();
+	}
+	~ProfileZone() {
+		profiler.addTime(zone, profiler.now() - start);
+	}
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+};
+#else
+#define PROFILE_ZONE(zone)
+#define PROFILE_BEGIN(zone)
+#define PROFILE_END(zone)
+
+// Stand-in with the same interface that does nothing
+class Profiler {
+public:
+	void setFont(sf::Font&) {}
+	void handleEvent(const sf::Event&) {}
+	bool isVisible() const {
+		return false;
+	}
+	void endFrame() {}
+	void draw(sf::RenderTarget&) {}
+};
+Profiler profiler;
+#endif
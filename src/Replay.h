@@ -0,0 +1,258 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
+#include "Snapshot.h"
+#include "Tile.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Draws board snapshots into RGBA pixel buffers on the CPU. Needs no window or GPU context,
+// so thumbnails and videos can be made anywhere. Only reads its settings, so one rasterizer can be shared by threads
+class BoardRasterizer {
+	int cellSize; // Pixels per cell
+	int meterWidth; // Garbage meter left of the board, including its gap
+	unsigned int width, height;
+
+	// Blend a solid rectangle over the buffer. Clipped to the image
+	void fillRect(sf::Uint8* pixels, int left, int top, int rectWidth, int rectHeight, const sf::Color& color) const {
+		int right = min(left + rectWidth, (int)width), bottom = min(top + rectHeight, (int)height);
+		left = max(left, 0), top = max(top, 0);
+		for (int y = top; y < bottom; y++) {
+			sf::Uint8* pixel = pixels + (y * width + left) * 4;
+			for (int x = left; x < right; x++, pixel += 4) {
+				pixel[0] = (color.r * color.a + pixel[0] * (255 - color.a)) / 255;
+				pixel[1] = (color.g * color.a + pixel[1] * (255 - color.a)) / 255;
+				pixel[2] = (color.b * color.a + pixel[2] * (255 - color.a)) / 255;
+				pixel[3] = 255;
+			}
+		}
+	}
+public:
+	BoardRasterizer(int cellSize = RASTERCELLSIZE) {
+		this->cellSize = cellSize;
+		meterWidth = cellSize / 2 + 2;
+		// Video chroma planes need even sizes
+		width = (meterWidth + NUMCOLS * cellSize + 1) & ~1;
+		height = (NUMROWS * cellSize + 1) & ~1;
+	}
+	unsigned int getWidth() const {
+		return width;
+	}
+	unsigned int getHeight() const {
+		return height;
+	}
+	// Draw the visible rows, ghost piece, and garbage meter of a snapshot into a width * height RGBA buffer
+	void draw(const BoardSnapshot& snapshot, sf::Uint8* pixels) const {
+		fillRect(pixels, 0, 0, width, height, BLACK);
+		fillRect(pixels, meterWidth, 0, NUMCOLS * cellSize, NUMROWS * cellSize, sf::Color(24, 24, 24));
+		for (int i = 2; i < REALNUMROWS; i++)
+			for (int j = 0; j < NUMCOLS; j++) {
+				unsigned char cell = snapshot.cells[i][j];
+				if (cell & (CELLLOCKED | CELLACTIVE | CELLGHOST))
+					fillRect(pixels, meterWidth + j * cellSize + 1, (i - 2) * cellSize + 1, cellSize - 1, cellSize - 1, getCellColor(cell, snapshot.colorPallete));
+			}
+		// Garbage meter fills from the bottom like GarbageStack
+		if (snapshot.gameMode != CLASSIC)
+			for (int i = 0; i < NUMROWS; i++) {
+				sf::Color color(40, 40, 40);
+				if (i < snapshot.garbageCount)
+					color = sf::Color(getGarbageShade(snapshot.garbage[i]), 0, 0);
+				fillRect(pixels, 0, NUMROWS * cellSize - (i + 1) * cellSize + 1, cellSize / 2, cellSize - 1, color);
+			}
+	}
+	// Draw a snapshot into an image
+	sf::Image getImage(const BoardSnapshot& snapshot) const {
+		vector<sf::Uint8> pixels(width * height * 4);
+		draw(snapshot, pixels.data());
+		sf::Image image;
+		image.create(width, height, pixels.data());
+		return image;
+	}
+	// Save a snapshot as an image. Format is picked from the extension
+	bool saveThumbnail(const BoardSnapshot& snapshot, const string& path) const {
+		return getImage(snapshot).saveToFile(path);
+	}
+};
+
+// Keeps snapshots of a board at REPLAYFPS so a game can be exported after it ends
+class ReplayRecorder {
+	vector<BoardSnapshot> frames;
+	float nextFrame; // Frame timestamp the next replay frame is due
+public:
+	ReplayRecorder() {
+		nextFrame = 0;
+	}
+	// Start a new recording
+	void clear() {
+		frames.clear();
+	}
+	// Keep the snapshot if a replay frame is due. Frames missed during a stall repeat it so the replay keeps real time
+	void record(const BoardSnapshot& snapshot, float now) {
+		if (frames.empty())
+			nextFrame = now;
+		while (nextFrame <= now && frames.size() < REPLAYMAXFRAMES) {
+			frames.push_back(snapshot);
+			nextFrame += 1.0f / REPLAYFPS;
+		}
+	}
+	const vector<BoardSnapshot>& getFrames() const {
+		return frames;
+	}
+	// Write the raw snapshots. Only readable by a build with the same BoardSnapshot layout
+	bool save(const string& path) const {
+		ofstream outFile(path, ios::binary);
+		uint32_t header[2] = { sizeof(BoardSnapshot), (uint32_t)frames.size() };
+		outFile.write((const char*)header, sizeof(header));
+		outFile.write((const char*)frames.data(), frames.size() * sizeof(BoardSnapshot));
+		return outFile.good();
+	}
+	// Replace the recording with snapshots written by save. Returns false if the file is missing or from another layout
+	bool load(const string& path) {
+		ifstream inFile(path, ios::binary);
+		uint32_t header[2];
+		if (!inFile.read((char*)header, sizeof(header)) || header[0] != sizeof(BoardSnapshot) || header[1] > REPLAYMAXFRAMES)
+			return false;
+		frames.resize(header[1]);
+		if (!inFile.read((char*)frames.data(), frames.size() * sizeof(BoardSnapshot))) {
+			frames.clear();
+			return false;
+		}
+		return true;
+	}
+};
+
+// Convert an RGBA buffer to planar YUV 4:2:0 (BT.601, limited range). Width and height must be even
+void convertToYUV420(const sf::Uint8* pixels, unsigned int width, unsigned int height, vector<unsigned char>& out) {
+	out.resize(width * height * 3 / 2);
+	unsigned char* yPlane = out.data();
+	unsigned char* uPlane = yPlane + width * height;
+	unsigned char* vPlane = uPlane + width * height / 4;
+	for (unsigned int y = 0; y < height; y++)
+		for (unsigned int x = 0; x < width; x++) {
+			const sf::Uint8* p = pixels + (y * width + x) * 4;
+			yPlane[y * width + x] = (unsigned char)(16 + (66 * p[0] + 129 * p[1] + 25 * p[2] + 128) / 256);
+		}
+	// Chroma from the average of each 2x2 block
+	for (unsigned int y = 0; y < height; y += 2)
+		for (unsigned int x = 0; x < width; x += 2) {
+			int r = 0, g = 0, b = 0;
+			for (unsigned int dy = 0; dy < 2; dy++)
+				for (unsigned int dx = 0; dx < 2; dx++) {
+					const sf::Uint8* p = pixels + ((y + dy) * width + x + dx) * 4;
+					r += p[0], g += p[1], b += p[2];
+				}
+			r /= 4, g /= 4, b /= 4;
+			int index = (y / 2) * (width / 2) + x / 2;
+			uPlane[index] = (unsigned char)(128 + (-38 * r - 74 * g + 112 * b + 128) / 256);
+			vPlane[index] = (unsigned char)(128 + (112 * r - 94 * g - 18 * b + 128) / 256);
+		}
+}
+
+// Write snapshots as a raw Y4M video. Batches of frames are rasterized and converted on every core,
+// then written in order. Returns false if the file could not be written
+bool exportY4M(const vector<BoardSnapshot>& frames, const string& path, int fps, const BoardRasterizer& rasterizer) {
+	ofstream outFile(path, ios::binary);
+	if (!outFile.is_open())
+		return false;
+	unsigned int width = rasterizer.getWidth(), height = rasterizer.getHeight();
+	outFile << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+
+	int threadCount = max(1u, thread::hardware_concurrency());
+	int batchSize = threadCount * REPLAYBATCHFRAMES;
+	vector<vector<unsigned char>> encoded(batchSize);
+	for (size_t start = 0; start < frames.size(); start += batchSize) {
+		int count = min((size_t)batchSize, frames.size() - start);
+		vector<thread> workers;
+		for (int t = 0; t < threadCount; t++)
+			workers.push_back(thread([&, t]() {
+				vector<sf::Uint8> pixels(width * height * 4);
+				for (int i = t; i < count; i += threadCount) {
+					rasterizer.draw(frames[start + i], pixels.data());
+					convertToYUV420(pixels.data(), width, height, encoded[i]);
+				}
+			}));
+		for (thread& worker : workers)
+			worker.join();
+		for (int i = 0; i < count; i++) {
+			outFile << "FRAME\n";
+			outFile.write((const char*)encoded[i].data(), encoded[i].size());
+		}
+	}
+	return outFile.good();
+}
+
+// Write the video, thumbnail, and snapshot file of a recording. Returns false if any failed
+bool exportReplay(const ReplayRecorder& recorder, const BoardRasterizer& rasterizer) {
+	const vector<BoardSnapshot>& frames = recorder.getFrames();
+	if (frames.empty())
+		return false;
+	bool saved = exportY4M(frames, REPLAYFILEPATH, REPLAYFPS, rasterizer);
+	saved = rasterizer.saveThumbnail(frames.back(), THUMBNAILFILEPATH) && saved;
+	return saved;
+}
+
+// Exports a copy of a recording on its own thread so the window and simulation keep running
+class ReplayExporter {
+	thread worker;
+	ReplayRecorder recording; // Copy owned by the worker while saving
+	BoardRasterizer rasterizer;
+	atomic<bool> finished;
+	bool saving, saved;
+public:
+	ReplayExporter() : finished(false) {
+		saving = false;
+		saved = false;
+	}
+	~ReplayExporter() { // Let a running export finish its files
+		if (worker.joinable())
+			worker.join();
+	}
+	bool isSaving() const {
+		return saving;
+	}
+	// Start saving a recording. Ignored while another export is running
+	void start(const ReplayRecorder& recorder) {
+		if (saving)
+			return;
+		if (worker.joinable())
+			worker.join();
+		recording = recorder;
+		saving = true;
+		finished = false;
+		worker = thread([this]() {
+			saved = recording.save(SNAPSHOTFILEPATH);
+			saved = exportReplay(recording, rasterizer) && saved;
+			finished = true;
+		});
+	}
+	// Returns true once after an export finishes, with whether every file was saved
+	bool takeResult(bool& saved) {
+		if (!saving || !finished)
+			return false;
+		worker.join();
+		recording.clear();
+		saving = false;
+		saved = this->saved;
+		return true;
+	}
+};
+
+// Export a snapshot file written by a previous game. Only rasterizes on the CPU, so no window or display is needed
+bool exportReplayFile(const string& path) {
+	ReplayRecorder recorder;
+	if (!recorder.load(path)) {
+		cout << "Could not read replay snapshots from " << path << "\n";
+		return false;
+	}
+	bool saved = exportReplay(recorder, BoardRasterizer());
+	cout << (saved ? "Saved replay to " + REPLAYFILEPATH + " and " + THUMBNAILFILEPATH + "\n" : "Failed to save replay\n");
+	return saved;
+}
@@ -5,6 +5,7 @@
 #include "Screen.h"
 #include "Drawing.h"
 #include "Mechanisms.h"
+#include "Assets.h"
 using namespace std;
 using namespace TetrisVariables;
 
@@ -18,23 +19,28 @@ class SandboxMenu : public sf::Drawable {
     Checkbox* quitBox; // Quit to menu
     vector<Checkbox*> sandboxes; // Pointer to boxes
     Screen* screen; // Game screen. Only links to player 1 as sandbox mode is single player
+    mutable VertexBatch boxBatch; // Boxes and arrows drawn in one call
 protected:
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
         for (const sf::Text& text : sandboxText)
             target.draw(text, states);
+        boxBatch.clear();
         for (auto box : sandboxes)
-            target.draw(*box, states);
+            box->addToBatch(boxBatch);
+        target.draw(boxBatch, states);
+        target.draw(gravityBox->getNumberText(), states);
     }
 public:
-    SandboxMenu(sf::Font& font, Screen* screen) {
+    SandboxMenu(sf::Font& font, Screen* screen, TextureAtlas& atlas) {
         vector<string> menuItems = { "Auto-fall", "Fall speed", "Creative", "Reset", "Quit" };
         for (int i = 0; i < menuItems.size(); i++)
             sandboxText.push_back(SfTextAtHome(font, WHITE, menuItems[i], MENUTEXTSIZE, { SANDBOXMENUPOS.x, SANDBOXMENUPOS.y + MENUSPACING * i }));
-        autoFallBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y, true, font);
-        gravityBox = new IncrementalBox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING, 1, GRAVITYTIERCOUNT, font);
-        creativeModeBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING * 2, false, font);
-        resetBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING * 3, false, font);
-        quitBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING * 4, false, font);
+        boxBatch = VertexBatch(atlas);
+        autoFallBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y, true, atlas);
+        gravityBox = new IncrementalBox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING, 1, GRAVITYTIERCOUNT, font, atlas);
+        creativeModeBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING * 2, false, atlas);
+        resetBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING * 3, false, atlas);
+        quitBox = new Checkbox(TILESIZE, SANDBOXMENUPOS.x + 180, SANDBOXMENUPOS.y + MENUSPACING * 4, false, atlas);
         sandboxes = { autoFallBox, gravityBox, creativeModeBox, resetBox, quitBox };
         this->screen = screen;
     }
@@ -76,7 +82,7 @@ public:
     }
     
     // Handle key presses for sandbox-exclusive functions. Pass in variables that may be manipulated
-    void onKeyPress(sf::Keyboard::Key& key, PieceBag& bag, sf::Music& bgm, int& currentScreen) {
+    void onKeyPress(sf::Keyboard::Key& key, PieceBag& bag, BackgroundMusic& bgm, int& currentScreen) {
         // Hot keys for sandbox controls
         if (key == sf::Keyboard::Q || key == sf::Keyboard::Escape)
             toggleGravity();
@@ -101,7 +107,7 @@ public:
             screen->receiveGarbage(4);
     }
     // Handle left mouse. Pass in variables that may be manipulated
-    void onLeftClick(sf::Vector2f& clickPos, PieceBag& bag, sf::Music& bgm, int& currentScreen){
+    void onLeftClick(sf::Vector2f& clickPos, PieceBag& bag, BackgroundMusic& bgm, int& currentScreen){
         if (autoFallBox->getBounds().contains(clickPos))  // Turn off gravity
             toggleGravity();
         else if (gravityBox->getLeftBound().contains(clickPos))  // Speed arrows
@@ -4,51 +4,47 @@
 #include <algorithm>
 #include "Tetromino.h"
 #include "Tile.h"
+#include "Snapshot.h"
 
 using namespace std;
 using namespace TetrisVariables;
 
+// Game state of one board. Advanced by the simulation thread and drawn by a BoardRenderer through snapshots
 class Screen {
 #pragma region Attributes
-	// HUD Items
-	vector<SfRectangleAtHome> screenRects;
-	sf::FloatRect gameBounds, holdBounds, queueBounds;
-	SfTextAtHome holdText, nextText, gamemodeText;
-	vector<SfRectangleAtHome> lines;
-
-	sf::RenderWindow* window;
-	sf::Texture* blockTexture;
+	sf::FloatRect gameBounds; // Board area including its outline. Used for clicks and tile positions
 	float gravity, startingGravity; // Seconds between automatic movements. Smaller gravity falls faster. 0 disables gravity. 
 	map<int, float> gravityTiers;
 
 	int totalLinesCleared, gameMode, playerIndex;
-	vector<vector<Tile>> board; // Coordinates are [row][col]
+	Tile board[REALNUMROWS][NUMCOLS]; // Coordinates are [row][col]
 
 	Tetromino* currentPiece;
 	Tetromino* heldPiece;
 	vector<Tetromino*> tetrominos;
 	vector<sf::Vector2i> currentPositions, previewPositions;
 
-	vector<vector<sf::Sprite>> nextPieceSprites;
 	vector<int> nextPieceQueue;
-	vector<sf::Sprite> heldSprite;
 
 	bool hasHeld, lockTimerStarted, touchedGround, creativeMode, autoFall, gameOver, paused;
 	bool lastMoveSpin; // For checking T-spins
 	sfClockAtHome gravityTimer, lockTimer, superLockTimer; // Timer to track gravity and locking
 
 	int comboCounter;
-	vector<FadeText> clearAnimations; // { &speedupText, &clearText, &b2bText, &comboText, &allClearText }
+	// Clear texts are played by the renderer. { speedup, clear, b2b, combo, all clear }
+	int clearTextSerials[CLEARANIMATIONCOUNT]; // Incremented each time a text is played
+	int clearTextValues[CLEARANIMATIONCOUNT]; // Clear type for the clear text, count for the combo text
 	bool backToBack; // Stores back-to-back clear flag
 	PieceBag* bag; // Stores the random piece generation
 
 	int inGarbage, outGarbage; // Lines of garbage to receive/send
 	GarbageBin bin; // Queue for garbage inventory
 	bool canDump; // Dump garbage if a piece has been set without clearing lines
-	GarbageStack garbStack; // Visuals for garbage
 	int garbLastCol; // Stores location of garbage for randomness settings
 
-	DeathAnimation deathAnimation;
+	int deathCount; // Incremented every time the death animation is played. Drawn by the renderer
+	int lineClearSerial; // Incremented every time lines are cleared. Flashed by the renderer
+	unsigned int clearedRows; // Bit per row removed by the latest clear, in board rows before the clear
 
 	// Customizable game settings
 	float lockDelay, superLockDelay;
@@ -62,16 +58,11 @@ class Screen {
 #pragma endregion
 
 public:
-	Screen(sf::RenderWindow& window, sf::Vector2f gamePos, sf::Font& font, sf::Texture* blockTexture, PieceBag* bag, SoundManager* soundFX) {
-		this->window = &window;
-		setHUD(gamePos, font);
-		this->blockTexture = blockTexture;
-		this->clearAnimations = clearAnimations;	// Pass animations to screen class to play when prompted
-		clearAnimations.push_back(FadeText(SfTextAtHome(font, WHITE, "SPEED UP", GAMETEXTSIZE * 2, { gamePos.x + GAMEWIDTH / 2, gamePos.y }, true, false, true), 1, 1));
-		clearAnimations.push_back(FadeText(SfTextAtHome(font, WHITE, "T-spin Triple", CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f }), 0, 2.5f));
-		clearAnimations.push_back(FadeText(SfTextAtHome(font, WHITE, "Back-to-Back", CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f + MENUSPACING }), 0, 2.5f));
-		clearAnimations.push_back(FadeText(SfTextAtHome(font, WHITE, "2X Combo", CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f + MENUSPACING * 2 }), 0, 2.5f));
-		clearAnimations.push_back(FadeText(SfTextAtHome(font, WHITE, "All Clear", CLEARTEXTSIZE, { gamePos.x + GAMEWIDTH + LINEWIDTH * 2, gamePos.y + GAMEHEIGHT / 1.5f + MENUSPACING * 3 }), 0, 2.5f));
+	Screen(sf::Vector2f gamePos, PieceBag* bag, SoundManager* soundFX) {
+		// Same bounds as the outlined game rectangle drawn by the renderer
+		gameBounds = sf::FloatRect(gamePos.x - LINEWIDTH, gamePos.y - LINEWIDTH, GAMEWIDTH + LINEWIDTH * 2, GAMEHEIGHT + LINEWIDTH * 2);
+		for (int i = 0; i < CLEARANIMATIONCOUNT; i++)
+			clearTextSerials[i] = 0, clearTextValues[i] = 0;
 
 		this->bag = bag;
 		this->soundFX = soundFX;
@@ -87,7 +78,8 @@ public:
 		colorPallete = 0;
 
 		playerIndex = bag->addPlayer();
-		totalLinesCleared = 0, comboCounter = 0;
+		totalLinesCleared = 0, comboCounter = 0, deathCount = 0;
+		lineClearSerial = 0, clearedRows = 0;
 		heldPiece = nullptr;
 		hasHeld = false, lockTimerStarted = false, touchedGround = false, backToBack = false;
 		creativeMode = false, autoFall = true, gameOver = false, canDump = true, paused = false;
@@ -95,28 +87,13 @@ public:
 		gravity = startingGravity;
 
 		tetrominos = { new IPiece, new JPiece, new LPiece, new OPiece, new SPiece, new ZPiece, new TPiece };
-		for (int i = 0; i < tetrominos.size(); i++) {
-			tetrominos[i]->setPieceCode(i); // Piece codes allow for specified piece spawns
-			tetrominos[i]->setColor(PIECECOLORSETS[colorPallete][i]);
-		}
-		for (int i = 0; i < nextPieceCount; i++) // Initialize next pieces sprites
-			nextPieceSprites.push_back(tetrominos[i]->getPieceSprite(*blockTexture, 0, 0, 1));
+		for (int i = 0; i < tetrominos.size(); i++)
+			tetrominos[i]->setPieceCode(i); // Piece codes allow for specified piece spawns. Also used as color indices
 		for (int i = 0; i < GRAVITYTIERCOUNT; i++) // Initialize gravity thresholds
 			gravityTiers[GRAVITYTIERLINES[i]] = GRAVITYSPEEDS[i];
 
-		deathAnimation = DeathAnimation({ gameBounds.left, gameBounds.top }, 2, 0.2f, *blockTexture);
-		garbStack = GarbageStack({ gameBounds.left, gameBounds.top });
 		garbLastCol = rand() % NUMCOLS; // Random column
 
-
-		// Generate board
-		for (int i = 0; i < REALNUMROWS; i++) {
-			vector<Tile> row;
-			for (int j = 0; j < NUMCOLS; j++) {
-				row.push_back(Tile(*blockTexture, gameBounds.left + j * TILESIZE, gameBounds.top + (i - 2) * TILESIZE));
-			}
-			board.push_back(row);
-		}
 		spawnPiece();
 	}
 
@@ -130,9 +107,6 @@ public:
 		// Disable if paused
 		if (paused)
 			return;
-		// Update garbageStack if gameMode is sandbox or PVP
-		if (gameMode != CLASSIC)
-			garbStack.updateStack(getStackVector());
 		// Handles gravity. Disabled if autoFall is off (sandbox exclusive)
 		if (gravityTimer.getTimeSeconds() >= gravity && gravity > 0 && autoFall) {
 			movePiece(1);
@@ -181,7 +155,7 @@ public:
 		if (pieceCode == -1) { // Generate random piece
 			if (bagEnabled) {
 				pieceCode = bag->getPiece(playerIndex);
-				nextPieceQueue = bag->getNextPieces(playerIndex, NEXTPIECECOUNT);
+				bag->getNextPieces(playerIndex, nextPieceQueue, NEXTPIECECOUNT);
 			}
 			else {
 				if (nextPieceQueue.size() < 7) // Replenish queue
@@ -190,11 +164,6 @@ public:
 				pieceCode = nextPieceQueue[0];
 				nextPieceQueue.erase(nextPieceQueue.begin());
 			}
-			for (int i = 0; i < nextPieceSprites.size(); i++) { // Display queue
-				nextPieceSprites[i] = tetrominos[nextPieceQueue[i]]->getPieceSprite(*blockTexture,
-					queueBounds.left + TILESIZE * HUDPIECESCALE,
-					queueBounds.top + i * 2.5f * TILESIZE * HUDPIECESCALE + TILESIZE / 2.0f, HUDPIECESCALE);
-			}
 		}
 		currentPiece = tetrominos[pieceCode]->getNewPiece();
 		updateBlocks();
@@ -257,6 +226,32 @@ public:
 		// Hide current tiles, update position, set new tiles
 		updateBlocks();
 	}
+	// Move left (0), down (1), or right (2) by up to count cells at once. Stops at walls and blocks.
+	// Used by auto repeat when several moves are owed in one tick
+	void shiftPiece(int direction, int count) {
+		if (paused)
+			return;
+		int moved = 0;
+		for (; moved < count; moved++) {
+			if (direction == 0 && checkLeft())
+				currentPiece->moveLeft();
+			else if (direction == 1 && checkBelow())
+				currentPiece->moveDown();
+			else if (direction == 2 && checkRight())
+				currentPiece->moveRight();
+			else
+				break;
+			updateBlocks();
+		}
+		if (moved == 0)
+			return;
+		lockTimer.restart();
+		lastMoveSpin = false;
+		if (direction == 1)
+			gravityTimer.restart();
+		else
+			soundFX->play(LIGHTTAP);
+	}
 	// Spin piece either counterclockwise or clockwise
 	void spinPiece(bool clockwise) {
 		// Disable if paused
@@ -315,7 +310,6 @@ public:
 			heldPiece->setPieceCode(currentPiece->getPieceCode());
 			spawnPiece(temp);
 		}
-		heldSprite = heldPiece->getPieceSprite(*blockTexture, holdBounds.left + TILESIZE * HUDPIECESCALE, holdBounds.top + TILESIZE / 2.0f * HUDPIECESCALE, HUDPIECESCALE);
 		hasHeld = true;
 		soundFX->play(MEDIUMBEEP);
 	}
@@ -335,29 +329,26 @@ public:
 	void doClearLines() {
 		int linesCleared = 0; // Counts amount of lines cleared by this piece for scoring
 		bool hasCleared = false;
+		unsigned int rows = 0;
 		bool isTspin = checkTspin(); // Check for t-spin before lines are cleared
 
 		for (int i = 0; i < REALNUMROWS; i++) {
 			if (checkLine(board[i])) {
-				// Move all rows above cleared row down
-				for (int j = 0; j < i; j++)
-					for (Tile& tile : board[j])
-						tile.moveDown();
-				board.erase(board.begin() + i);
-
-				// Insert new row at top
-				vector<Tile> newRow;
-				for (int j = 0; j < NUMCOLS; j++) {
-					newRow.push_back(Tile(*blockTexture, gameBounds.left + j * TILESIZE, gameBounds.top - 2 * TILESIZE));
-				}
-				board.insert(board.begin(), newRow);
+				// Move all rows above cleared row down and empty the top row
+				for (int j = i; j > 0; j--)
+					copy(board[j - 1], board[j - 1] + NUMCOLS, board[j]);
+				for (Tile& tile : board[0])
+					tile.clear();
 				totalLinesCleared++;
 				linesCleared++;
 				hasCleared = true;
+				rows |= 1u << i; // Rows below are never shifted, so i is still the row's original index
 			}
 		}
 		canDump = !hasCleared; // For garbage
 		if (hasCleared) { // Execute when lines have been cleared
+			clearedRows = rows;
+			lineClearSerial++;
 			clearMovingSprites(); // Cleaning up sprite flags
 			soundFX->pauseAll();
 			soundFX->play(HIGHHIGHBEEP);
@@ -370,7 +361,7 @@ public:
 						playBackToBackText();
 						sendGarbage(1);
 					}
-					playClearText("T-spin Single");
+					playClearText(TSPINSINGLECLEAR);
 					sendGarbage(2);
 					backToBack = true; // backToBack = isTspin
 				}
@@ -384,12 +375,12 @@ public:
 						playBackToBackText();
 						sendGarbage(1);
 					}
-					playClearText("T-spin Double");
+					playClearText(TSPINDOUBLECLEAR);
 					sendGarbage(4);
 					backToBack = true;
 				}
 				else {
-					playClearText("Double");
+					playClearText(DOUBLECLEAR);
 					sendGarbage(1);
 					backToBack = false;
 				}
@@ -400,12 +391,12 @@ public:
 						playBackToBackText();
 						sendGarbage(3);
 					}
-					playClearText("T-spin Triple");
+					playClearText(TSPINTRIPLECLEAR);
 					sendGarbage(6);
 					backToBack = true;
 				}
 				else {
-					playClearText("Triple");
+					playClearText(TRIPLECLEAR);
 					sendGarbage(2);
 					backToBack = false;
 				}
@@ -415,7 +406,7 @@ public:
 					playBackToBackText();
 					sendGarbage(2);
 				}
-				playClearText("Tetris");
+				playClearText(TETRISCLEAR);
 				sendGarbage(4);
 				backToBack = true;
 				break;
@@ -475,18 +466,12 @@ public:
 	}
 	// Clear board and restart game. Reset gravity and piece queue
 	void resetBoard() {
-		board.clear();
-		// Generate new board
-		for (int i = 0; i < REALNUMROWS; i++) {
-			vector<Tile> row;
-			for (int j = 0; j < NUMCOLS; j++) {
-				row.push_back(Tile(*blockTexture, gameBounds.left + j * TILESIZE, gameBounds.top + (i - 2) * TILESIZE));
-			}
-			board.push_back(row);
-		}
+		// Empty the board
+		for (int i = 0; i < REALNUMROWS; i++)
+			for (Tile& tile : board[i])
+				tile.clear();
 		clearMovingSprites();
 		heldPiece = nullptr;
-		heldSprite.clear();
 		if (gameMode != SANDBOX) // Reset gravity if not in sandbox mode
 			resetGravity();
 		gravityTimer.restart(), lockTimer.restart(), superLockTimer.restart();
@@ -528,7 +513,7 @@ public:
 			return;
 		if (totalLinesCleared >= iter->first && gravity >= iter->second) {
 			setGravity(iter->second);
-			clearAnimations[0].restart();
+			clearTextSerials[0]++;
 		}
 	}
 
@@ -543,7 +528,6 @@ public:
 		if (lineCount == 0)
 			return;
 		bin.addGarbage(lineCount);
-		bin.getBin();
 	}
 	// Check garbage bin. See if garbage should be dumped.
 	void updateGarbage() {
@@ -563,16 +547,12 @@ public:
 					return;
 				}
 
-			// Move all rows up
-			for (int j = 0; j < REALNUMROWS; j++)
-				for (Tile& tile : board[j])
-					tile.moveUp();
-			board.erase(board.begin());
-
-			// Insert new row at bottom
-			vector<Tile> newRow;
+			// Move all rows up and empty the bottom row
+			for (int j = 0; j < REALNUMROWS - 1; j++)
+				copy(board[j + 1], board[j + 1] + NUMCOLS, board[j]);
+			Tile* newRow = board[REALNUMROWS - 1];
 			for (int j = 0; j < NUMCOLS; j++)
-				newRow.push_back(Tile(*blockTexture, gameBounds.left + j * TILESIZE, gameBounds.top + GAMEHEIGHT - TILESIZE));
+				newRow[j].clear();
 
 			// Fill in new row except one square.
 			int randomColumn;
@@ -586,9 +566,8 @@ public:
 			}
 			for (int j = 0; j < NUMCOLS; j++) {
 				if (j != randomColumn)
-					newRow[j].setBlock(true, WHITE);
+					newRow[j].setBlock(true, GARBAGECOLOR);
 			}
-			board.insert(board.end(), newRow);
 		}
 		inGarbage = 0;
 		soundFX->play(LOWBEEP);
@@ -596,56 +575,9 @@ public:
 #pragma endregion
 
 #pragma region Getters/Setters
-	// Create HUD on game position
-	void setHUD(sf::Vector2f gamePos, sf::Font& font) {
-		// Rectangles for game screen, hold, queue, garbage bin, and top row, 
-		screenRects.push_back(SfRectangleAtHome(BLACK, { GAMEWIDTH, GAMEHEIGHT },
-			gamePos, false, WHITE, LINEWIDTH));
-		screenRects.push_back(SfRectangleAtHome(BLACK, { TILESIZE * 4, TILESIZE * 4 },
-			{ gamePos.x - TILESIZE * 4.5f - LINEWIDTH, gamePos.y + LINEWIDTH }, false, WHITE, LINEWIDTH));
-		screenRects.push_back(SfRectangleAtHome(BLACK, { TILESIZE * 4, GAMEHEIGHT / 9 * NEXTPIECECOUNT },
-			{ gamePos.x + GAMEWIDTH + LINEWIDTH, gamePos.y + LINEWIDTH }, false, WHITE, LINEWIDTH));
-		screenRects.push_back(SfRectangleAtHome(BLACK, { TILESIZE / 2, GAMEHEIGHT - LINEWIDTH },
-			{ gamePos.x - TILESIZE / 2 - LINEWIDTH, gamePos.y + LINEWIDTH }, false, WHITE, LINEWIDTH));
-
-		// Rectangles to show a couple pixels of the very top row
-		screenRects.push_back(SfRectangleAtHome(BLACK, { GAMEWIDTH, TOPROWPIXELS },
-			{ gamePos.x, gamePos.y - TOPROWPIXELS }, false, WHITE, LINEWIDTH));
-		screenRects.push_back(SfRectangleAtHome(BLUE, { GAMEWIDTH + 1, TILESIZE - 9 },
-			{ gamePos.x - 1, gamePos.y - TILESIZE - 1 }));
-
-		// Get bounds of first three rectangles (game, hold, queue)
-		gameBounds = screenRects[0].getGlobalBounds();
-		holdBounds = screenRects[1].getGlobalBounds();
-		queueBounds = screenRects[2].getGlobalBounds();
-
-
-		// Generate all static text on game screen
-		holdText = SfTextAtHome(font, WHITE, "Hold", GAMETEXTSIZE, { holdBounds.left + holdBounds.width / 2, holdBounds.top - GAMETEXTSIZE }, true, false, true);
-		nextText = SfTextAtHome(font, WHITE, "Next", GAMETEXTSIZE, { queueBounds.left + queueBounds.width / 2, queueBounds.top - GAMETEXTSIZE }, true, false, true);
-		gamemodeText = SfTextAtHome(font, WHITE, "Classic Mode", GAMETEXTSIZE * 2, { gameBounds.left + gameBounds.width / 2, gameBounds.top - GAMETEXTSIZE * 2 }, true, false, true);
-
-		// Generate game field lines
-		for (int i = 1; i < NUMROWS; i++) { // Horizontal lines
-			lines.push_back(SfRectangleAtHome(SEETHROUGH, { GAMEWIDTH, LINEWIDTH }, { gameBounds.left, gameBounds.top + i * TILESIZE - 1 }));
-		}
-		for (int j = 1; j < NUMCOLS; j++) { // Vertical lines
-			lines.push_back(SfRectangleAtHome(SEETHROUGH, { LINEWIDTH, GAMEHEIGHT + TOPROWPIXELS },
-				{ gameBounds.left + j * TILESIZE - 1, gameBounds.top - TOPROWPIXELS }));
-		}
-	}
 	sf::FloatRect& getGameBounds() {
 		return gameBounds;
 	}
-	void setGamemodeTextString(string str) {
-		gamemodeText.setString(str);
-	}
-	void setGamemodeTextXPos(float x) {
-		gamemodeText.setPosition(x, gamemodeText.getPosition().y);
-	}
-	vector<SfRectangleAtHome>& getScreenRects() {
-		return screenRects;
-	}
 	// Set gravity to a specific speed or back to its starting speed
 	void setGravity(float speed) {
 		gravity = speed;
@@ -695,11 +627,6 @@ public:
 	void setColorPallete(int val) {
 		// Update color pallete
 		colorPallete = val;
-		for (int i = 0; i < tetrominos.size(); i++)
-			tetrominos[i]->setColor(PIECECOLORSETS[colorPallete][i]);
-	}
-	sf::Texture& getBlockTexture(){
-		return *blockTexture;
 	}
 	int getLinesCleared() {
 		return totalLinesCleared;
@@ -720,15 +647,36 @@ public:
 		outGarbage = 0;
 		return temp;
 	}
-	// Return vector for drawing GarbageStack
-	vector<float> getStackVector() {
-		if (creativeMode) // Return nothing if creative mode is on
-			return {};
-		vector<float> vec = bin.getBin();
-		// Add a 1 for each garbage line ready to dump
-		for (int i = 0; i < inGarbage; i++)
-			vec.insert(vec.begin(), 1);
-		return vec;
+	// Write the progress of each garbage line for drawing GarbageStack. Returns the number of lines written
+	int writeStack(float* progress, int capacity) {
+		if (creativeMode) // Write nothing if creative mode is on
+			return 0;
+		// Lines ready to dump come first at full progress
+		int count = 0;
+		for (; count < inGarbage && count < capacity; count++)
+			progress[count] = 1;
+		return count + bin.writeProgress(progress + count, capacity - count);
+	}
+	// Copy everything the renderer needs into a snapshot
+	void writeSnapshot(BoardSnapshot& snapshot) {
+		for (int i = 0; i < REALNUMROWS; i++)
+			for (int j = 0; j < NUMCOLS; j++)
+				snapshot.cells[i][j] = board[i][j].getState();
+		snapshot.heldPiece = heldPiece == nullptr ? -1 : heldPiece->getPieceCode();
+		for (int i = 0; i < NEXTPIECECOUNT; i++)
+			snapshot.nextPieces[i] = i < nextPieceQueue.size() ? nextPieceQueue[i] : 0;
+		snapshot.nextPieceCount = nextPieceCount, snapshot.colorPallete = colorPallete;
+		snapshot.gameMode = gameMode, snapshot.linesCleared = totalLinesCleared;
+		snapshot.holdEnabled = holdEnabled, snapshot.paused = paused, snapshot.gameOver = gameOver;
+		snapshot.deathCount = deathCount;
+		snapshot.lineClearSerial = lineClearSerial, snapshot.clearedRows = clearedRows;
+		bool falling = !paused && !gameOver && autoFall && gravity > 0 && checkBelow();
+		snapshot.fallProgress = falling ? min(gravityTimer.getTimeSeconds() / gravity, 1.0f) : 0;
+		snapshot.garbageCount = writeStack(snapshot.garbage, NUMROWS);
+		for (int i = 0; i < CLEARANIMATIONCOUNT; i++) {
+			snapshot.clearTextSerials[i] = clearTextSerials[i];
+			snapshot.clearTextValues[i] = clearTextValues[i];
+		}
 	}
 #pragma endregion
 
@@ -768,7 +716,7 @@ public:
 		int row = (int)((clickPos.y - gameBounds.top) / TILESIZE + 2); // Adjust to exclude the rows outside of game window
 		for (int i = 0; i < NUMCOLS; i++) {
 			if (!board[row][i].getHasMovingBlock())
-				board[row][i].setBlock(true, WHITE);
+				board[row][i].setBlock(true, GARBAGECOLOR);
 		}
 		board[row][col].setBlock(false);
 		updateBlocks();
@@ -776,50 +724,13 @@ public:
 #pragma endregion
 
 #pragma region Graphics
-	// Draw all tiles, held piece, and queue pieces
-	void drawScreen() {
-		// Last rectangle needs to be redrawn manually
-		for (const SfRectangleAtHome& rect : screenRects)
-			window->draw(rect);
-		if (!paused) {
-			for (const SfRectangleAtHome& line : lines)
-				window->draw(line);
-			for (int i = 1; i < REALNUMROWS; i++) {
-				for (int j = 0; j < NUMCOLS; j++) {
-					window->draw(board[i][j]);
-				}
-			}
-			for (sf::Sprite& sprite : heldSprite)
-				window->draw(sprite);
-			for (int i = 0; i < nextPieceCount; i++)
-				for (sf::Sprite& sprite : nextPieceSprites[i])
-					window->draw(sprite);
-
-			// Draw garbage stack if game mode is sandbox or PVP
-			if (gameMode != CLASSIC)
-				window->draw(garbStack);
-		}
-		// Enable death animation if game is over
-		if (gameOver)
-			deathAnimation.update(*window);
-
-		window->draw(screenRects.back()); // Redraw last rectangle
-
-		if (holdEnabled)
-			window->draw(holdText);
-		if (nextPieceCount > 0)
-			window->draw(nextText);
-		window->draw(gamemodeText);
-		for (FadeText& animation : clearAnimations)
-			animation.update(*window);
-	}
 	// Hide current moving tiles, update position, set new tiles
 	void updateBlocks() {
 		if (currentPositions.size() != 0)
 			setMovingBlocks(currentPositions, false);
 		currentPositions = currentPiece->getPositions();
 		updatePreview();
-		setMovingBlocks(currentPositions, true, currentPiece->color);
+		setMovingBlocks(currentPositions, true, currentPiece->getPieceCode());
 	}
 	// Update ghost piece visuals
 	void updatePreview() {
@@ -835,36 +746,32 @@ public:
 				for (sf::Vector2i& pos : previewPositions)
 					pos.x++;
 		}
-		sf::Color previewColor = currentPiece->color;
 		if (ghostPieceEnabled)
-			previewColor.a = PREVIEWTRANSPARENCY;
-		else // Disable ghost piece
-			previewColor.a = 0;
-		setPreviewBlocks(previewPositions, true, previewColor);
+			setPreviewBlocks(previewPositions, true, currentPiece->getPieceCode());
 	}
 	void setBlocks(vector<sf::Vector2i>& positions, bool value) {
 		for (sf::Vector2i& pos : positions)
 			board[pos.x][pos.y].setBlock(value);
 	}
-	void setBlocks(vector<sf::Vector2i>& positions, bool value, sf::Color& color) {
+	void setBlocks(vector<sf::Vector2i>& positions, bool value, int colorIndex) {
 		for (sf::Vector2i& pos : positions)
-			board[pos.x][pos.y].setBlock(value, color);
+			board[pos.x][pos.y].setBlock(value, colorIndex);
 	}
 	void setMovingBlocks(vector<sf::Vector2i>& positions, bool value) {
 		for (sf::Vector2i& pos : positions)
 			board[pos.x][pos.y].setMovingBlock(value);
 	}
-	void setMovingBlocks(vector<sf::Vector2i>& positions, bool value, sf::Color& color) {
+	void setMovingBlocks(vector<sf::Vector2i>& positions, bool value, int colorIndex) {
 		for (sf::Vector2i& pos : positions)
-			board[pos.x][pos.y].setMovingBlock(value, color);
+			board[pos.x][pos.y].setMovingBlock(value, colorIndex);
 	}
 	void setPreviewBlocks(vector<sf::Vector2i>& positions, bool value) {
 		for (sf::Vector2i& pos : positions)
 			board[pos.x][pos.y].setPreviewBlock(value);
 	}
-	void setPreviewBlocks(vector<sf::Vector2i>& positions, bool value, sf::Color& color) {
+	void setPreviewBlocks(vector<sf::Vector2i>& positions, bool value, int colorIndex) {
 		for (sf::Vector2i& pos : positions)
-			board[pos.x][pos.y].setPreviewBlock(value, color);
+			board[pos.x][pos.y].setPreviewBlock(value, colorIndex);
 	}
 	// Hard reset moving and preview block sprites to debug.
 	void clearMovingSprites() {
@@ -876,24 +783,24 @@ public:
 		}
 	}
 	// Play fadeText animations
-	void playClearText(string str) {
-		clearAnimations[1].setString(str);
-		clearAnimations[1].restart();
+	void playClearText(int clearType) {
+		clearTextValues[1] = clearType;
+		clearTextSerials[1]++;
 	}
 	void playBackToBackText() {
-		clearAnimations[2].restart();
+		clearTextSerials[2]++;
 	}
 	void playComboText() {
-		clearAnimations[3].setString(to_string(comboCounter) + "X Combo");
-		clearAnimations[3].restart();
+		clearTextValues[3] = comboCounter;
+		clearTextSerials[3]++;
 	}
 	void playAllClearText() {
-		clearAnimations[4].restart();
+		clearTextSerials[4]++;
 	}
-	// Play death animation. This is performed right before game over.
+	// Play death animation. This is performed right before game over. The renderer draws it once it sees the new count
 	// NOTE: This will be called by main to avoid bugs with simultaneous loss in pvp
 	void playDeathAnimation() {
-		deathAnimation.restart();
+		deathCount++;
 		soundFX->pauseAll();
 		soundFX->play(LOWTHUD);
 	}
@@ -929,9 +836,9 @@ public:
 		return true;
 	}
 	// Return true if a row is filled.
-	bool checkLine(vector<Tile>& row) {
-		for (Tile& tile : row)
-			if (!tile.getHasBlock())
+	bool checkLine(const Tile* row) {
+		for (int j = 0; j < NUMCOLS; j++)
+			if (!row[j].getHasBlock())
 				return false;
 		return true;
 	}
@@ -961,9 +868,8 @@ public:
 
 		return cornerBlockCount >= 3;
 	}
-	// Check if death animation has finished playing
-	bool isDeathAnimationOver() {
-		return deathAnimation.isOver();
+	int getDeathCount() {
+		return deathCount;
 	}
 #pragma endregion
 };
\ No newline at end of file
@@ -0,0 +1,241 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <SFML/System.hpp>
+#include "TetrisConstants.h"
+#include "Mechanisms.h"
+#include "Screen.h"
+#include "Snapshot.h"
+#include "Profiler.h"
+#include "Spectator.h"
+#include "Input.h"
+#include "Commands.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Runs game timers and auto-repeat on their own thread at TICKRATE, independent of drawing.
+// Every tick publishes a snapshot of each board to a triple buffer. The main thread takes the state lock
+// only while it applies input, and draws from the newest snapshots without locking
+class Simulation {
+	vector<Screen*> screens; // { solo or player 1, player 2, spectator boards... }
+	int playerBoards; // Screens before the spectator boards
+	vector<KeyDAS*> dasSets; // { solo, player 1, player 2 }
+	vector<SpectatorBot> bots; // One per spectator board
+	vector<TripleBuffer<BoardSnapshot>*> snapshots; // One per screen
+	InputQueue input; // Key changes from the key listener or the window's events. Drained every tick
+	ActionTable actionTables[2]; // Key lookup for each player of the current mode
+	vector<CommandBuffer> commands; // One per screen. Filled by input and bots, run every tick
+	int appliedSequences[2]; // Latest followed press applied to each player board. For the latency harness
+	mutex stateLock; // Guards the screens, DAS sets, piece bag, and sound effects
+	condition_variable modeChanged;
+	thread worker;
+	atomic<bool> running;
+	int mode; // Screen being simulated. Guarded by stateLock
+
+	// Only game screens advance on their own
+	static bool isGameMode(int mode) {
+		return mode == CLASSIC || mode == SANDBOX || mode == MULTIPLAYER || mode == SPECTATE;
+	}
+	// Control profiles of the players in a mode
+	vector<KeyDAS*> getPlayers(int mode) {
+		if (mode == CLASSIC || mode == SANDBOX)
+			return { dasSets[0] };
+		if (mode == MULTIPLAYER)
+			return { dasSets[1], dasSets[2] };
+		return {};
+	}
+	// Turn every key change queued since the last tick into commands. Player i controls screen i
+	void drainInput() {
+		int players = getPlayers(mode).size();
+		KeyEvent keyEvent;
+		while (input.pop(keyEvent)) {
+			for (int i = 0; i < players; i++) {
+				int action = actionTables[i].getAction(keyEvent.key);
+				if (action != ACTIONNONE)
+					commands[i].push({ action, keyEvent.pressed, keyEvent.time, keyEvent.sequence });
+			}
+		}
+	}
+	// Run the commands buffered for a screen. das is null for boards without auto repeat
+	void runCommands(int board, KeyDAS* das) {
+		for (int i = 0; i < commands[board].size(); i++) {
+			const Command& command = commands[board][i];
+			if (runCommand(screens[board], das, command) && command.sequence > 0) {
+				latency.onApplied(command.sequence, LATENCYACTIONS[command.action], command.time);
+				appliedSequences[board] = command.sequence;
+			}
+		}
+		commands[board].clear();
+	}
+	// Thread loop. Sleeps on menus and keeps a fixed tick schedule in game
+	void run() {
+		const sf::Time tickLength = sf::seconds(1.f / TICKRATE);
+		sf::Clock clock;
+		sf::Time nextTick;
+		unique_lock<mutex> guard(stateLock);
+		while (running) {
+			if (!isGameMode(mode)) {
+				modeChanged.wait(guard, [this] { return !running || isGameMode(mode); });
+				nextTick = clock.getElapsedTime();
+				continue;
+			}
+			tick();
+			publish();
+			guard.unlock();
+
+			// Skip ahead instead of catching up after a long stall
+			nextTick += tickLength;
+			sf::Time now = clock.getElapsedTime();
+			if (nextTick > now)
+				sf::sleep(nextTick - now);
+			else if (now - nextTick > tickLength * 8.f)
+				nextTick = now;
+			guard.lock();
+		}
+	}
+	// Advance the boards of the current mode by one tick
+	void tick() {
+		{
+			PROFILE_ZONE(PROFILERDAS);
+			drainInput();
+		}
+		float now = getInputTime();
+		switch (mode)
+		{
+		case CLASSIC:
+		case SANDBOX:
+			{
+				// Handles movement with auto-repeat (DAS)
+				PROFILE_ZONE(PROFILERDAS);
+				runCommands(0, dasSets[0]);
+				dasSets[0]->update(screens[0], now);
+			}
+			{
+				// In-game timer events
+				PROFILE_ZONE(PROFILERTIMERS);
+				screens[0]->doTimeStuff();
+			}
+			break;
+		case MULTIPLAYER:
+			{
+				PROFILE_ZONE(PROFILERDAS);
+				runCommands(0, dasSets[1]);
+				runCommands(1, dasSets[2]);
+				dasSets[1]->update(screens[0], now);
+				dasSets[2]->update(screens[1], now);
+			}
+			{
+				PROFILE_ZONE(PROFILERTIMERS);
+				screens[0]->doTimeStuff();
+				screens[1]->doTimeStuff();
+				// Process garbage exchange
+				screens[0]->receiveGarbage(screens[1]->getOutGarbage());
+				screens[1]->receiveGarbage(screens[0]->getOutGarbage());
+			}
+			break;
+		case SPECTATE:
+			for (int i = playerBoards; i < screens.size(); i++) {
+				bots[i - playerBoards].update(screens[i], commands[i], now);
+				runCommands(i, nullptr);
+				screens[i]->doTimeStuff();
+			}
+			break;
+		default:
+			break;
+		}
+	}
+public:
+	Simulation(vector<Screen*> screens, vector<KeyDAS*> dasSets, vector<Screen*> spectators) : running(false) {
+		this->screens = screens;
+		this->dasSets = dasSets;
+		playerBoards = screens.size();
+		this->screens.insert(this->screens.end(), spectators.begin(), spectators.end());
+		bots.resize(spectators.size());
+		for (int i = 0; i < this->screens.size(); i++)
+			snapshots.push_back(new TripleBuffer<BoardSnapshot>);
+		commands.resize(this->screens.size());
+		mode = MAINMENU;
+		appliedSequences[0] = appliedSequences[1] = 0;
+	}
+	~Simulation() {
+		stop();
+		for (TripleBuffer<BoardSnapshot>* snapshot : snapshots)
+			delete snapshot;
+	}
+	void start() {
+		running = true;
+		worker = thread(&Simulation::run, this);
+	}
+	// Stop and join the thread. Must be called before the screens are deleted
+	void stop() {
+		if (!worker.joinable())
+			return;
+		{
+			lock_guard<mutex> guard(stateLock);
+			running = false;
+		}
+		modeChanged.notify_all();
+		worker.join();
+	}
+	// Key changes are pushed by the key listener and the main thread
+	InputQueue& getInput() {
+		return input;
+	}
+	// Called once per loop by the main thread while it holds the state lock. Keys are only queued while the window has focus
+	void updateInput(bool focused) {
+		input.setFocused(focused);
+		input.update(getInputTime());
+	}
+	// Held by the main thread while it handles input that touches the screens
+	mutex& getLock() {
+		return stateLock;
+	}
+	// Set the screen to simulate. Caller must hold the state lock.
+	// Keys are released on a change and queued again from the current keybinds
+	void setMode(int mode) {
+		if (this->mode == mode)
+			return;
+		this->mode = mode;
+		refreshKeys();
+		modeChanged.notify_all();
+	}
+	// Release every key and queue from the current keybinds. Caller must hold the state lock
+	void refreshKeys() {
+		for (KeyDAS* das : dasSets)
+			das->releaseAll(getInputTime());
+		// Only the keys of this mode's players are queued
+		vector<KeyDAS*> players = getPlayers(mode);
+		vector<sf::Keyboard::Key> keys;
+		for (int i = 0; i < players.size(); i++) {
+			actionTables[i].build(players[i]->getKeySet());
+			for (sf::Keyboard::Key* key : players[i]->getKeySet()->getSet())
+				keys.push_back(*key);
+		}
+		for (CommandBuffer& buffer : commands)
+			buffer.clear();
+		input.watch(keys);
+		input.setActive(!keys.empty());
+	}
+	// Copy the boards of the current mode into their next snapshots. Caller must hold the state lock
+	void publish() {
+		int first = mode == SPECTATE ? playerBoards : 0;
+		int last = mode == SPECTATE ? screens.size() : playerBoards;
+		for (int i = first; i < last; i++) {
+			screens[i]->writeSnapshot(snapshots[i]->getWriteBuffer());
+			snapshots[i]->getWriteBuffer().inputSequence = i < playerBoards ? appliedSequences[i] : 0;
+			snapshots[i]->publish();
+		}
+	}
+	// Newest complete snapshot of a board. Spectator boards follow the player boards.
+	// Only called from the main thread and never blocks
+	const BoardSnapshot& getSnapshot(int board) {
+		snapshots[board]->update();
+		return snapshots[board]->read();
+	}
+	const BoardSnapshot& getSpectatorSnapshot(int index) {
+		return getSnapshot(playerBoards + index);
+	}
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Everything needed to draw one board. Written by the simulation and read by the renderer
+struct BoardSnapshot {
+	unsigned char cells[REALNUMROWS][NUMCOLS]; // Packed tile states. See CELLCOLORMASK
+	int heldPiece; // Piece code. -1 if nothing is held
+	int nextPieces[NEXTPIECECOUNT];
+	int nextPieceCount, colorPallete, gameMode, linesCleared;
+	bool holdEnabled, paused, gameOver;
+	int deathCount; // Increments every time the death animation is played
+	float fallProgress; // Part of the gravity interval that has passed while the piece can fall. Visual only
+	float garbage[NUMROWS]; // Timer progress of each incoming garbage line. 1 when ready to dump
+	int garbageCount;
+	int clearTextSerials[CLEARANIMATIONCOUNT]; // Increments every time a clear text is played
+	int clearTextValues[CLEARANIMATIONCOUNT]; // Clear type for the clear text, count for the combo text
+	int lineClearSerial; // Increments every time lines are cleared
+	unsigned int clearedRows; // Bit per board row removed by the latest clear
+	int inputSequence; // Latest input sequence applied to the board. Only set in latency harness builds
+
+	BoardSnapshot() {
+		for (int i = 0; i < REALNUMROWS; i++)
+			for (int j = 0; j < NUMCOLS; j++)
+				cells[i][j] = 0;
+		for (int i = 0; i < NEXTPIECECOUNT; i++)
+			nextPieces[i] = 0;
+		for (int i = 0; i < CLEARANIMATIONCOUNT; i++)
+			clearTextSerials[i] = 0, clearTextValues[i] = 0;
+		heldPiece = -1;
+		nextPieceCount = 0, colorPallete = 0, gameMode = MAINMENU, linesCleared = 0;
+		holdEnabled = false, paused = false, gameOver = false;
+		deathCount = 0, garbageCount = 0;
+		lineClearSerial = 0, clearedRows = 0;
+		inputSequence = 0;
+		fallProgress = 0;
+	}
+};
+
+// Lock-free handoff of complete values from one writer thread to one reader thread.
+// The writer fills the back buffer and publishes it. The reader swaps in the newest published buffer.
+// Neither side ever waits, and a buffer being read is never written.
+template <typename T>
+class TripleBuffer {
+	static const unsigned char INDEXMASK = 3, FRESH = 4; // Middle index with a flag for unread data
+	T buffers[3];
+	atomic<unsigned char> middle;
+	unsigned char back, front; // Owned by the writer and reader respectively
+public:
+	TripleBuffer() : middle(1) {
+		back = 0;
+		front = 2;
+	}
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+	// Buffer for the writer to fill
+	T& getWriteBuffer() {
+		return buffers[back];
+	}
+	// Make the write buffer the newest complete value
+	void publish() {
+		back = middle.exchange(back | FRESH, memory_order_acq_rel) & INDEXMASK;
+	}
+	// Swap in the newest value if one was published since the last call. Returns true if it changed
+	bool update() {
+		if (!(middle.load(memory_order_acquire) & FRESH))
+			return false;
+		front = middle.exchange(front, memory_order_acq_rel) & INDEXMASK;
+		return true;
+	}
+	// Newest value the reader has swapped in
+	const T& read() const {
+		return buffers[front];
+	}
+};
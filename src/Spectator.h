@@ -0,0 +1,138 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
+#include "Atlas.h"
+#include "Mechanisms.h"
+#include "Screen.h"
+#include "Snapshot.h"
+#include "Tile.h"
+#include "Commands.h"
+
+using namespace std;
+using namespace TetrisVariables;
+
+// Plays a spectator board with random placements so the spectator grid has live boards to show.
+// Each piece gets a random spin and shift, one command at a time, then is hard dropped
+class SpectatorBot {
+	int spins, shift; // Actions left for the current piece. Negative shift moves left
+	float actionDelay; // Seconds between actions. Varies by bot so boards do not move in step
+	sfClockAtHome actionTimer, gameOverTimer;
+	bool wasGameOver;
+
+	void planPiece() {
+		spins = rand() % 4;
+		shift = rand() % NUMCOLS - NUMCOLS / 2;
+	}
+public:
+	SpectatorBot() {
+		actionDelay = SPECTATORACTIONDELAY * (0.5f + rand() % 100 / 100.0f);
+		wasGameOver = false;
+		planPiece();
+	}
+	// Queue the next command if one is due. Restarts the board a while after it tops out
+	void update(Screen* screen, CommandBuffer& commands, float now) {
+		if (screen->getGameOver()) {
+			if (!wasGameOver)
+				gameOverTimer.restart();
+			wasGameOver = true;
+			if (gameOverTimer.getTimeSeconds() >= SPECTATORRESETDELAY) {
+				screen->resetBoard();
+				wasGameOver = false;
+			}
+			return;
+		}
+		if (actionTimer.getTimeSeconds() < actionDelay)
+			return;
+		actionTimer.restart();
+		if (spins > 0) {
+			commands.push({ ACTIONSPINCW, true, now, 0 });
+			spins--;
+		}
+		else if (shift != 0) {
+			commands.push({ shift < 0 ? ACTIONLEFT : ACTIONRIGHT, true, now, 0 });
+			shift += shift < 0 ? 1 : -1;
+		}
+		else {
+			commands.push({ ACTIONHARDDROP, true, now, 0 });
+			planPiece();
+		}
+	}
+};
+
+// Draws many boards at a reduced scale with a minimal HUD: a border, the garbage meter, and a dimmed game over.
+// Board frames are built once per layout and every board goes into one batch, so a grid is a single draw call
+class SpectatorGrid {
+	VertexBatch batch;
+	vector<sf::Vertex> frames; // Backgrounds and borders of every board
+	vector<sf::Vector2f> origins; // Top left of each board's visible rows
+	float cellSize;
+	sf::Vector2f whiteTexel;
+
+	// Append a solid quad to a vertex list
+	void addFrameQuad(float left, float top, float width, float height, const sf::Color& color) {
+		frames.push_back(sf::Vertex({ left, top }, color, whiteTexel));
+		frames.push_back(sf::Vertex({ left + width, top }, color, whiteTexel));
+		frames.push_back(sf::Vertex({ left + width, top + height }, color, whiteTexel));
+		frames.push_back(sf::Vertex({ left, top + height }, color, whiteTexel));
+	}
+public:
+	SpectatorGrid() {
+		cellSize = 0;
+	}
+	SpectatorGrid(const TextureAtlas& atlas, int boardCount, sf::FloatRect area) : batch(atlas) {
+		whiteTexel = atlas.getWhiteTexel();
+		setLayout(boardCount, area);
+	}
+	// Fit a number of boards into an area. Picks the column count that gives the largest whole pixel cells
+	void setLayout(int boardCount, sf::FloatRect area) {
+		// Each board is its columns plus one for the garbage meter, and one cell of spacing on each axis
+		const int boardCols = NUMCOLS + 2, boardRows = NUMROWS + 1;
+		int columns = 1;
+		cellSize = 0;
+		for (int c = 1; c <= boardCount; c++) {
+			int rows = (boardCount + c - 1) / c;
+			float size = floor(min(area.width / (c * boardCols), area.height / (rows * boardRows)));
+			if (size > cellSize)
+				cellSize = size, columns = c;
+		}
+		cellSize = max(cellSize, 1.0f);
+
+		frames.clear();
+		origins.clear();
+		for (int i = 0; i < boardCount; i++) {
+			sf::Vector2f origin(area.left + (i % columns * boardCols + 1.5f) * cellSize, area.top + (i / columns * boardRows + 0.5f) * cellSize);
+			origins.push_back(origin);
+			addFrameQuad(origin.x - 1, origin.y - 1, NUMCOLS * cellSize + 2, NUMROWS * cellSize + 2, GRAY); // Border
+			addFrameQuad(origin.x, origin.y, NUMCOLS * cellSize, NUMROWS * cellSize, BLACK);
+			addFrameQuad(origin.x - cellSize, origin.y, cellSize / 2, NUMROWS * cellSize, sf::Color(40, 40, 40)); // Garbage meter
+		}
+	}
+	int getBoardCount() const {
+		return origins.size();
+	}
+	// Draw one snapshot per board in layout order
+	void draw(sf::RenderTarget& target, const vector<const BoardSnapshot*>& snapshots) {
+		batch.clear();
+		batch.addVertices(frames.data(), frames.size(), ORIGIN);
+		float tile = cellSize >= 4 ? cellSize - 1 : cellSize; // Keep a gap between cells once there is room for it
+		for (int b = 0; b < snapshots.size() && b < origins.size(); b++) {
+			const BoardSnapshot& snapshot = *snapshots[b];
+			const sf::Vector2f& origin = origins[b];
+			for (int i = 2; i < REALNUMROWS; i++)
+				for (int j = 0; j < NUMCOLS; j++) {
+					unsigned char cell = snapshot.cells[i][j];
+					if (cell & (CELLLOCKED | CELLACTIVE | CELLGHOST))
+						batch.addSolidQuad({ origin.x + j * cellSize, origin.y + (i - 2) * cellSize, tile, tile }, getCellColor(cell, snapshot.colorPallete));
+				}
+			for (int i = 0; i < snapshot.garbageCount; i++) {
+				sf::Color color(getGarbageShade(snapshot.garbage[i]), 0, 0);
+				batch.addSolidQuad({ origin.x - cellSize, origin.y + (NUMROWS - i - 1) * cellSize, cellSize / 2, tile }, color);
+			}
+			if (snapshot.gameOver)
+				batch.addSolidQuad({ origin.x, origin.y, NUMCOLS * cellSize, NUMROWS * cellSize }, sf::Color(0, 0, 0, 160));
+		}
+		target.draw(batch);
+	}
+};
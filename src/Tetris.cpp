@@ -1,15 +1,26 @@
 #include <iostream>
+#include <cstring>
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 #include <fstream>
 #include <map>
 #include <vector>
+#include <mutex>
 #include "TetrisConstants.h"
+#include "Atlas.h"
+#include "Assets.h"
 #include "Mechanisms.h"
 #include "Drawing.h"
 #include "Screen.h"
+#include "BoardRenderer.h"
+#include "Simulation.h"
+#include "FrameScheduler.h"
 #include "GameSettings.h"
+#include "ConfigWatcher.h"
 #include "Sandbox.h"
+#include "Replay.h"
+#include "Spectator.h"
+#include "KeyListener.h" // Last, since it pulls in Xlib on Linux
 
 using namespace std;
 using namespace TetrisVariables;
@@ -18,62 +29,76 @@ using namespace TetrisVariables;
 // Sound effects and music made with IOS Garage Band
 // Line count as of 5/11/2024: 3937
 
-// Generate text for loss screen
+// Generate text for loss screen. The first LOSSBANNERCOUNT texts are the banners, one of which is shown.
+// They are followed by the return prompt, the replay prompt, and the text shown while a replay saves
+const int LOSSBANNERCOUNT = 4, YOULOST = 0, P2WINS = 1, DRAW = 2, P1WINS = 3;
 vector<sf::Text> getLossText(sf::Font& font) {
 	vector<sf::Text> textboxes;
-	textboxes.push_back(SfTextAtHome(font, WHITE, "YOU LOST", GAMETEXTSIZE * 4, { WIDTH / 2, GAMEYPOS }, true, false, true));
+	for (string banner : { "YOU LOST", "PLAYER 2 WINS!", "DRAW!", "PLAYER 1 WINS!" })
+		textboxes.push_back(SfTextAtHome(font, WHITE, banner, GAMETEXTSIZE * 4, { WIDTH / 2, GAMEYPOS }, true, false, true));
 	textboxes.push_back(SfTextAtHome(font, WHITE, "Press any key to return to Main Menu", GAMETEXTSIZE, { WIDTH / 2, HEIGHT / 2 }, true, false, true));
+	textboxes.push_back(SfTextAtHome(font, WHITE, "Press F9 to save a replay of a classic game", GAMETEXTSIZE, { WIDTH / 2, HEIGHT / 2 + MENUSPACING }, true, false, true));
+	textboxes.push_back(SfTextAtHome(font, WHITE, "Saving replay...", GAMETEXTSIZE, { WIDTH / 2, HEIGHT / 2 + MENUSPACING }, true, false, true));
 
 	return textboxes;
 }
 
-// Load in all clip timestamps
-SoundManager* generateSoundManager() {
-	SoundManager* soundFX = new SoundManager(SOUNDFXFILEPATH);
-	soundFX->addEffect(MEDIUMBEEP);
-	soundFX->addEffect(HIGHBEEP);
-	soundFX->addEffect(LIGHTTAP);
-	soundFX->addEffect(HIGHHIGHBEEP);
-	soundFX->addEffect(LOWBEEP);
-	soundFX->addEffect(LOWTHUD);
+// Cut every clip from the decoded soundboard
+SoundManager* generateSoundManager(const sf::SoundBuffer& soundboard) {
+	SoundManager* soundFX = new SoundManager(soundboard);
 	soundFX->setVolume(20);
 	return soundFX;
 }
 
-int main() {
+int main(int argc, char** argv) {
 	srand(time(NULL));
+	latency.parseArgs(argc, argv); // Only used by builds with the latency harness
+	// Export a saved recording and quit without opening a window. Works on machines with no display
+	for (int i = 1; i + 1 < argc; i++)
+		if (strcmp(argv[i], "--export-replay") == 0)
+			return exportReplayFile(argv[i + 1]) ? 0 : -1;
 #pragma region SFML Setup
-	// Set SFML objects
+	// Set SFML objects. Files are read and decoded on worker threads while the window opens
 	sf::Font font;
-	if (!font.loadFromFile(FONTFILEPATH))
-		return -1;
-	sf::Texture texture;
-	if (!texture.loadFromFile(BLOCKFILEPATH))
-		return -1;
-	SoundManager* soundFX = generateSoundManager();
-	sf::Music bgm;
-	if (!bgm.openFromFile(BGMFILEPATH))
-		return -1;
-	bgm.setVolume(BGMVOLUME);
-	bgm.setLoop(true);
+	TextureAtlas atlas; // Block tile and UI shapes share one texture
+	sf::SoundBuffer soundboard;
+	BackgroundMusic bgm; // Streams until the settings pick otherwise
+	AssetLoader assets(font, atlas, soundboard, bgm);
 
 	sf::ContextSettings windowSettings;
 	windowSettings.antialiasingLevel = 8;
+	assets.beginStep();
 	sf::RenderWindow window(sf::VideoMode(WIDTH, HEIGHT), "Tetris", sf::Style::Close | sf::Style::Titlebar, windowSettings);
-	window.setFramerateLimit(FPS);
 	window.setKeyRepeatEnabled(false);
+	assets.endStep("Window");
+
+	if (!assets.wait(ASSETFONT))
+		return -1;
+	profiler.setFont(font); // Only used by builds with the frame profiler
+	if (!assets.finish(ASSETATLAS, [&]() { return atlas.upload(); }))
+		return -1;
+	if (!assets.wait(ASSETSOUNDS)) {
+		cout << "Missing audio file";
+		return -1;
+	}
+	SoundManager* soundFX = generateSoundManager(soundboard);
+	if (!assets.wait(ASSETMUSIC))
+		return -1;
+	bgm.setVolume(BGMVOLUME);
+	bgm.setLoop(true);
 #pragma endregion
 
 #pragma region Basic Assets
 	// Title screen sprites
 	sf::Text titleText(SfTextAtHome(font, WHITE, "TETRIS", 150, TITLETEXTPOS, true, false, true));
-	sf::CircleShape* cursor = new sf::CircleShape(15.f, 3); // Triangle shaped cursor
-	cursor->rotate(90.f);
-	vector<string> menuText = { "Classic Mode", "Sandbox Mode", "PVP Mode", "Settings", "Quit" };
-	ClickableMenu gameMenu(font, WHITE, menuText, MENUTEXTSIZE, MENUPOS, MENUSPACING, *cursor);
+	sf::Sprite cursor = atlas.getTriangleSprite(15.f); // Triangle shaped cursor
+	cursor.rotate(90.f);
+	vector<string> menuText = { "Classic Mode", "Sandbox Mode", "PVP Mode", "Spectate", "Settings", "Quit" };
+	ClickableMenu gameMenu(font, WHITE, menuText, MENUTEXTSIZE, MENUPOS, MENUSPACING, cursor);
 
 	// Text for loss screen
 	vector<sf::Text> lossText = getLossText(font);
+	int lossBanner = YOULOST;
 #pragma endregion
 
 #pragma region Controller Classes
@@ -92,39 +117,84 @@ int main() {
 	PieceBag bag;
 
 	// Set up game screen
-	Screen* screen = new Screen(window, GAMEPOS, font, &texture, &bag, soundFX);
-	Screen* screenP2 = new Screen(window, GAMEPOSP2, font, &texture, &bag, soundFX);
-	screenP2->setGamemodeTextString("PVP Mode"); // This will be the title text used in pvp mode. Hide the other title text
-	screenP2->setGamemodeTextXPos(WIDTH);
-	
-	sf::Text linesClearedText = SfTextAtHome(font, WHITE, "Lines: 0", 25, { GAMEXPOS + GAMEWIDTH + 150, GAMEYPOS });
+	Screen* screen = new Screen(GAMEPOS, &bag, soundFX);
+	Screen* screenP2 = new Screen(GAMEPOSP2, &bag, soundFX);
+	// Board visuals. Drawn from the snapshots published by the simulation
+	BoardRenderer renderer(GAMEPOS, font, atlas);
+	BoardRenderer rendererP2(GAMEPOSP2, font, atlas);
+	rendererP2.setGamemodeTextString("PVP Mode"); // This will be the title text used in pvp mode. Hide the other title text
+	rendererP2.setGamemodeTextXPos(WIDTH);
+
+	// Spectator boards are played by bots. They use their own bag and a muted sound manager
+	PieceBag spectatorBag;
+	SoundManager* spectatorFX = generateSoundManager(soundboard);
+	spectatorFX->setVolume(0);
+	vector<Screen*> spectators;
+	for (int i = 0; i < SPECTATORBOARDCOUNT; i++) {
+		spectators.push_back(new Screen(ORIGIN, &spectatorBag, spectatorFX));
+		spectators.back()->setGameMode(CLASSIC);
+	}
+	SpectatorGrid spectatorGrid(atlas, SPECTATORBOARDCOUNT, sf::FloatRect(0, 0, WIDTH * 2, HEIGHT));
+	vector<const BoardSnapshot*> spectatorSnapshots;
+
+	CounterText linesClearedText(font, WHITE, "Lines: ", "", 25, { GAMEXPOS + GAMEWIDTH + 150, GAMEYPOS });
 	int currentScreen = MAINMENU;
 
 	// Pause screen sprites
 	vector<string> pauseMenuText = { "Continue", "Restart", "Quit" };
-	PauseScreen pauseMenu(GAMEPOS, pauseMenuText, font);
+	PauseScreen pauseMenu(GAMEPOS, pauseMenuText, font, atlas);
 	// Sandbox mode exclusive sprites
-	SandboxMenu* sandboxMenu = new SandboxMenu(font, screen);
-	// Set up settings menu
-	SettingsMenu gameSettings({ screen, screenP2 }, { playerSoloDAS, player1DAS, player2DAS }, soundFX, font, &bgm, &currentScreen);
+	SandboxMenu* sandboxMenu = new SandboxMenu(font, screen, atlas);
+	// Classic games are kept for export from the loss screen
+	ReplayRecorder recorder;
+	ReplayExporter exporter; // Saves on its own thread
+	// Skips drawing frames where nothing has changed. Frame rate is set from the settings menu
+	FrameScheduler frames;
+	// Set up settings menu. Timed since it lays out every tab and reads the config file
+	assets.beginStep();
+	SettingsMenu gameSettings({ screen, screenP2 }, { playerSoloDAS, player1DAS, player2DAS }, soundFX, font, atlas, &bgm, &frames, &currentScreen);
+	assets.endStep("Settings menu");
+	// Edits to the config file apply while the game runs
+	ConfigWatcher configWatcher(CONFIGFILEPATH);
+	configWatcher.start();
+	// Game timers run on their own thread from here on. Anything touching the screens must hold its lock
+	Simulation simulation({ screen, screenP2 }, { playerSoloDAS, player1DAS, player2DAS }, spectators);
+	frames.setInput(&simulation.getInput()); // Polled game keys go straight to the simulation
+	KeyListener keyListener(simulation.getInput()); // Reads game keys off the main thread where it can
+	keyListener.start(window);
+	latency.setScript(playerSoloKeys); // Injected presses use the solo keybinds
+	simulation.start();
 
 	// Game loop
 	while (window.isOpen())
 	{
-		// Manage audio across all screens
-		soundFX->checkTimers();
+		bgm.update(); // Swap in preloaded music once decoded, outside the state lock
+
+		// Input and state changes. The simulation thread waits until drawing starts
+		unique_lock<mutex> stateGuard(simulation.getLock());
+
+		// Finished replay export. The state lock keeps the beep off the voices the simulation plays
+		bool replaySaved;
+		if (exporter.takeResult(replaySaved)) {
+			cout << (replaySaved ? "Saved replay to " + REPLAYFILEPATH + " and " + THUMBNAILFILEPATH + "\n" : "Failed to save replay\n");
+			soundFX->play(replaySaved ? HIGHBEEP : LOWBEEP);
+			frames.markDirty(); // Take down the saving text
+		}
+
+		// Settings changed in the config file. Holding the state lock keeps this between ticks
+		vector<int> configChanges;
+		if (configWatcher.takeChanges(configChanges) && gameSettings.reloadConfig(configChanges))
+			simulation.refreshKeys();
+
+		PROFILE_BEGIN(PROFILERINPUT);
 
 		// Run on main menu
 		if (currentScreen == MAINMENU) {
-			window.clear(BLUE);
-			window.draw(titleText);
-			window.draw(gameMenu);
-
 			bool modeSelected = false;
 
 			// Event handler for menu screen
 			sf::Event event;
-			while (window.pollEvent(event)) {
+			while (frames.pollEvent(window, event)) {
 				switch (event.type)
 				{
 				case sf::Event::Closed:
@@ -158,6 +228,9 @@ int main() {
 					break;
 				}
 			}
+			// The latency harness starts classic games on its own
+			if (latency.isInjecting())
+				modeSelected = true;
 
 			// Select menu option if modeSelected is true
 			if (modeSelected) {
@@ -167,16 +240,17 @@ int main() {
 				case 0: // Classic mode
 					currentScreen = CLASSIC;
 					screen->setGameMode(CLASSIC);
-					screen->setGamemodeTextString("Classic Mode");
+					renderer.setGamemodeTextString("Classic Mode");
 					screen->setAutoFall(true);
 					screen->endCreativeMode();
 					bag.resetQueue();
 					screen->resetBoard();
+					recorder.clear();
 					bgm.play();
 					break;
 				case 1: // Sandbox mode
 					currentScreen = SANDBOX;
-					screen->setGamemodeTextString("Sandbox Mode");
+					renderer.setGamemodeTextString("Sandbox Mode");
 					screen->setGameMode(SANDBOX);
 					sandboxMenu->reset();
 					screen->setAutoFall(true);
@@ -191,7 +265,7 @@ int main() {
 					window.setView(sf::View(sf::FloatRect(0, 0, WIDTH * 2, HEIGHT)));
 					window.setPosition({ 100, 100 });
 					screen->setGameMode(MULTIPLAYER);
-					screen->setGamemodeTextString("");
+					renderer.setGamemodeTextString("");
 					screen->setAutoFall(true);
 					screen->endCreativeMode();
 					bag.resetQueue();
@@ -199,13 +273,23 @@ int main() {
 
 					screenP2->setGameMode(MULTIPLAYER);
 					screenP2->resetBoard();
+					recorder.clear(); // Only classic games are recorded
 					bgm.play();
 					break;
-				case 3: // Settings
+				case 3: // Spectator grid
+					currentScreen = SPECTATE;
+					window.setSize({ WIDTH * 2, HEIGHT });
+					window.setView(sf::View(sf::FloatRect(0, 0, WIDTH * 2, HEIGHT)));
+					window.setPosition({ 100, 100 });
+					spectatorBag.resetQueue();
+					for (Screen* spectator : spectators)
+						spectator->resetBoard();
+					break;
+				case 4: // Settings
 					gameSettings.selectTab(0);
 					currentScreen = SETTINGSCREEN;
 					break;
-				case 4: // Quit
+				case 5: // Quit
 					window.close();
 					break;
 				default:
@@ -216,38 +300,20 @@ int main() {
 		}
 		// Run on classic mode
 		else if (currentScreen == CLASSIC) {
-			window.clear(BLUE);
-			screen->drawScreen();
-
-			// This is only shown in classic mode
-			linesClearedText.setString("Lines: " + to_string(screen->getLinesCleared()));
-			window.draw(linesClearedText);
-
-			if (screen->getPaused() && !screen->getGameOver())
-				window.draw(pauseMenu);
 			bool modeSelected = false; // For pause screen
 
-			// Manage audio
-			soundFX->checkTimers();
-
-			// In-game timer events
-			screen->doTimeStuff();
-
 			// Check for game over
 			if (screen->getGameOver()) {
 				bgm.stop();
-				if (screen->isDeathAnimationOver()) {
-					currentScreen = LOSESCREEN;
-					lossText[0] = SfTextAtHome(font, WHITE, "YOU LOST", GAMETEXTSIZE * 4, { WIDTH / 2, GAMEYPOS }, true, false, true);
+				if (renderer.isDeathAnimationOver(screen->getDeathCount())) {
+					currentScreen = latency.isInjecting() ? MAINMENU : LOSESCREEN; // The harness keeps playing
+					lossBanner = YOULOST;
 				}
 			}
 
-			// Handles movement with auto-repeat (DAS)
-			playerSoloDAS->checkKeyPress(screen);
-
 			// Event handler for game screen
 			sf::Event event;
-			while (window.pollEvent(event)) {
+			while (frames.pollEvent(window, event)) {
 				switch (event.type)
 				{
 				case sf::Event::Closed:
@@ -267,16 +333,7 @@ int main() {
 						else if (event.key.code == sf::Keyboard::Z)
 							modeSelected = true;
 					}
-					else { // Game controls
-						if (event.key.code == playerSoloKeys->getUp())
-							screen->movePiece(3);
-						else if (event.key.code == playerSoloKeys->getSpinCCW())
-							screen->spinPiece(false);
-						else if (event.key.code == playerSoloKeys->getSpinCW())
-							screen->spinPiece(true);
-						else if (event.key.code == playerSoloKeys->getHold())
-							screen->holdPiece();
-					}
+					// Game controls are queued for the simulation when the event is polled
 					if (event.key.code == sf::Keyboard::Escape) {
 						screen->doPauseResume();
 						pauseMenu.getMenu().resetCursorPos();
@@ -284,9 +341,6 @@ int main() {
 					}
 					break;
 				}
-				case sf::Event::KeyReleased: {
-					playerSoloDAS->releaseKey(event.key.code);
-				}
 				case sf::Event::MouseButtonPressed: {
 					if (screen->getPaused() && pauseMenu.getMenu().onMouseClick(event.mouseButton.x, event.mouseButton.y))
 						modeSelected = true;
@@ -312,6 +366,7 @@ int main() {
 				case 1: // Restart
 					bag.resetQueue();
 					screen->resetBoard();
+					recorder.clear();
 					soundFX->play(HIGHBEEP);
 					break;
 				case 2: // Quit
@@ -328,22 +383,9 @@ int main() {
 		}
 		// Run on sandbox mode
 		else if (currentScreen == SANDBOX) {
-			window.clear(BLUE);
-			screen->drawScreen();
-			window.draw(*sandboxMenu);
-
-			// Manage audio
-			soundFX->checkTimers();
-
-			// In-game timer events
-			screen->doTimeStuff();
-
-			// Handles movement with auto-repeat (DAS)
-			playerSoloDAS->checkKeyPress(screen);
-
 			// Event handler for game screen
 			sf::Event event;
-			while (window.pollEvent(event)) {
+			while (frames.pollEvent(window, event)) {
 				switch (event.type)
 				{
 				case sf::Event::Closed:
@@ -351,23 +393,15 @@ int main() {
 					break;
 				case sf::Event::KeyPressed:
 				{
-					if (event.key.code == playerSoloKeys->getUp())
-						screen->movePiece(3);
-					else if (event.key.code == playerSoloKeys->getSpinCCW())
-						screen->spinPiece(false);
-					else if (event.key.code == playerSoloKeys->getSpinCW())
-						screen->spinPiece(true);
-					else if (event.key.code == playerSoloKeys->getHold())
-						screen->holdPiece();
-					else if (event.key.code >= sf::Keyboard::Num1 && event.key.code <= sf::Keyboard::Num7)
+					// Game controls are queued for the simulation when the event is polled
+					if (playerSoloKeys->isActionKey(event.key.code))
+						break;
+					if (event.key.code >= sf::Keyboard::Num1 && event.key.code <= sf::Keyboard::Num7)
 						screen->spawnPiece(event.key.code - 27);
 					else // Check for sandbox hotkeys
 						sandboxMenu->onKeyPress(event.key.code, bag, bgm, currentScreen);
 					break;
 				}
-				case sf::Event::KeyReleased: {
-					playerSoloDAS->releaseKey(event.key.code);
-				}
 				case sf::Event::MouseButtonPressed: {
 					sf::Vector2f clickPos(event.mouseButton.x, event.mouseButton.y);
 					if (event.mouseButton.button == sf::Mouse::Left) {
@@ -391,57 +425,35 @@ int main() {
 		}
 		// Run on PVP mode
 		else if (currentScreen == MULTIPLAYER) {
-			window.clear(BLUE);
-			screen->drawScreen();
-			screenP2->drawScreen();
-
-
-			if (screen->getPaused() && !screen->getGameOver() && !screenP2->getGameOver())
-				window.draw(pauseMenu);
 			bool modeSelected = false; // For pause screen
 
-			// Manage audio
-			soundFX->checkTimers();
-
-			// In-game timer events
-			screen->doTimeStuff();
-			screenP2->doTimeStuff();
-
-			// Process garbage exchange
-			screen->receiveGarbage(screenP2->getOutGarbage());
-			screenP2->receiveGarbage(screen->getOutGarbage());
-
 			// Check for game over
 			if (screen->getGameOver()) {
 				bgm.stop();
 				screenP2->pauseGame();
-				if (screen->isDeathAnimationOver()) {
+				if (renderer.isDeathAnimationOver(screen->getDeathCount())) {
 					window.setSize({ WIDTH, HEIGHT });
 					window.setView(sf::View(sf::FloatRect(0, 0, WIDTH, HEIGHT)));
 					currentScreen = LOSESCREEN;
-					lossText[0] = SfTextAtHome(font, WHITE, "PLAYER 2 WINS!", GAMETEXTSIZE * 4, { WIDTH / 2, GAMEYPOS }, true, false, true);
-					if (screenP2->getGameOver() && screenP2->isDeathAnimationOver()) // Rare event if both players lose at the same time
-						lossText[0] = SfTextAtHome(font, WHITE, "DRAW!", GAMETEXTSIZE * 4, { WIDTH / 2, GAMEYPOS }, true, false, true);
+					lossBanner = P2WINS;
+					if (screenP2->getGameOver() && rendererP2.isDeathAnimationOver(screenP2->getDeathCount())) // Rare event if both players lose at the same time
+						lossBanner = DRAW;
 				}
 			}
 			else if (screenP2->getGameOver()) {
 				bgm.stop();
 				screen->pauseGame();
-				if (screenP2->isDeathAnimationOver()) {
+				if (rendererP2.isDeathAnimationOver(screenP2->getDeathCount())) {
 					window.setSize({ WIDTH, HEIGHT });
 					window.setView(sf::View(sf::FloatRect(0, 0, WIDTH, HEIGHT)));
 					currentScreen = LOSESCREEN;
-					lossText[0] = SfTextAtHome(font, WHITE, "PLAYER 1 WINS!", GAMETEXTSIZE * 4, { WIDTH / 2, GAMEYPOS }, true, false, true);
+					lossBanner = P1WINS;
 				}
 			}
 
-			// Handles movement with auto-shift (DAS)
-			player1DAS->checkKeyPress(screen);
-			player2DAS->checkKeyPress(screenP2);
-
 			// Event handler for game screen
 			sf::Event event;
-			while (window.pollEvent(event)) {
+			while (frames.pollEvent(window, event)) {
 				switch (event.type)
 				{
 				case sf::Event::Closed:
@@ -461,24 +473,7 @@ int main() {
 						else if (event.key.code == sf::Keyboard::Z)
 							modeSelected = true;
 					}
-					else {
-						if (event.key.code == player1Keys->getUp())
-							screen->movePiece(3);
-						else if (event.key.code == player1Keys->getSpinCCW())
-							screen->spinPiece(false);
-						else if (event.key.code == player1Keys->getSpinCW())
-							screen->spinPiece(true);
-						else if (event.key.code == player1Keys->getHold())
-							screen->holdPiece();
-						else if (event.key.code == player2Keys->getUp())
-							screenP2->movePiece(3);
-						else if (event.key.code == player2Keys->getSpinCCW())
-							screenP2->spinPiece(false);
-						else if (event.key.code == player2Keys->getSpinCW())
-							screenP2->spinPiece(true);
-						else if (event.key.code == player2Keys->getHold())
-							screenP2->holdPiece();
-					}
+					// Game controls are queued for the simulation when the event is polled
 					if (event.key.code == sf::Keyboard::Escape) {
 						// Pause game and show menu. Disable during death animation for bug fix
 						if (!screen->getGameOver() && !screenP2->getGameOver()) {
@@ -490,10 +485,6 @@ int main() {
 					}
 					break;
 				}
-				case sf::Event::KeyReleased: {
-					player1DAS->releaseKey(event.key.code);
-					player2DAS->releaseKey(event.key.code);
-				}
 				case sf::Event::MouseButtonPressed: {
 					if (screen->getPaused() && pauseMenu.getMenu().onMouseClick(event.mouseButton.x, event.mouseButton.y))
 						modeSelected = true;
@@ -539,21 +530,19 @@ int main() {
 			}
 		}
 		else if (currentScreen == LOSESCREEN) {
-			window.clear(BLACK);
-			for (sf::Text& text : lossText)
-				window.draw(text);
-
-			// Manage audio
-			soundFX->checkTimers();
-
 			sf::Event event;
-			while (window.pollEvent(event)) {
+			while (frames.pollEvent(window, event)) {
 				switch (event.type)
 				{
 				case sf::Event::Closed:
 					window.close();
 					break;
 				case sf::Event::KeyPressed:
+					if (event.key.code == sf::Keyboard::F9) { // Export the last classic game
+						if (!recorder.getFrames().empty())
+							exporter.start(recorder);
+						break;
+					}
 					currentScreen = MAINMENU;
 					soundFX->play(MEDIUMBEEP);
 					break;
@@ -566,15 +555,30 @@ int main() {
 				}
 			}
 		}
+		else if (currentScreen == SPECTATE) {
+			sf::Event event;
+			while (frames.pollEvent(window, event)) {
+				switch (event.type)
+				{
+				case sf::Event::Closed:
+					window.close();
+					break;
+				case sf::Event::KeyPressed: // Escape returns to the menu
+					if (event.key.code != sf::Keyboard::Escape)
+						break;
+					window.setSize({ WIDTH, HEIGHT });
+					window.setView(sf::View(sf::FloatRect(0, 0, WIDTH, HEIGHT)));
+					currentScreen = MAINMENU;
+					soundFX->play(MEDIUMBEEP);
+					break;
+				default:
+					break;
+				}
+			}
+		}
 		else if (currentScreen == SETTINGSCREEN) {
-			window.clear(BLUE);
-			window.draw(gameSettings);
-
-			// Manage audio
-			soundFX->checkTimers();
-
 			sf::Event event;
-			while (window.pollEvent(event)) {
+			while (frames.pollEvent(window, event)) {
 				switch (event.type)
 				{
 				case sf::Event::Closed:
@@ -597,10 +601,110 @@ int main() {
 				}
 			}
 		}
-		window.display();
+		// Publish input right away instead of waiting for the next tick
+		simulation.setMode(currentScreen);
+		simulation.updateInput(frames.hasFocus());
+		simulation.publish();
+		PROFILE_END(PROFILERINPUT);
+		stateGuard.unlock();
+
+		// Drawing only reads the newest snapshots and never waits on the simulation
+		const BoardSnapshot& snapshot = simulation.getSnapshot(0);
+		const BoardSnapshot& snapshotP2 = simulation.getSnapshot(1);
+		int frameSequence = max(snapshot.inputSequence, snapshotP2.inputSequence); // Latest press this frame shows
+
+		// Every animation in the frame uses the same timestamp
+		float now = frames.stampFrame();
+
+		// Game screens change on their own while running. Everything else only changes on input
+		bool animating = false;
+		if (currentScreen == CLASSIC || currentScreen == SANDBOX)
+			animating = renderer.isAnimating(snapshot, now);
+		else if (currentScreen == MULTIPLAYER)
+			animating = renderer.isAnimating(snapshot, now) || rendererP2.isAnimating(snapshotP2, now);
+		else if (currentScreen == SPECTATE)
+			animating = true;
+		animating = animating || profiler.isVisible(); // Overlay updates every frame
+		if (currentScreen == CLASSIC)
+			recorder.record(snapshot, now);
+		if (frames.beginFrame(currentScreen, animating)) {
+			if (currentScreen == MAINMENU) {
+				window.clear(BLUE);
+				window.draw(titleText);
+				window.draw(gameMenu);
+			}
+			else if (currentScreen == CLASSIC) {
+				window.clear(BLUE);
+				PROFILE_BEGIN(PROFILERBOARD1);
+				renderer.drawScreen(window, snapshot, now);
+				PROFILE_END(PROFILERBOARD1);
+
+				// This is only shown in classic mode
+				linesClearedText.setValue(snapshot.linesCleared); // Only rebuilds digits when the count changes
+				window.draw(linesClearedText);
+
+				if (snapshot.paused && !snapshot.gameOver)
+					window.draw(pauseMenu);
+			}
+			else if (currentScreen == SANDBOX) {
+				window.clear(BLUE);
+				PROFILE_BEGIN(PROFILERBOARD1);
+				renderer.drawScreen(window, snapshot, now);
+				PROFILE_END(PROFILERBOARD1);
+				window.draw(*sandboxMenu);
+			}
+			else if (currentScreen == MULTIPLAYER) {
+				window.clear(BLUE);
+				PROFILE_BEGIN(PROFILERBOARD1);
+				renderer.drawScreen(window, snapshot, now);
+				PROFILE_END(PROFILERBOARD1);
+				PROFILE_BEGIN(PROFILERBOARD2);
+				rendererP2.drawScreen(window, snapshotP2, now);
+				PROFILE_END(PROFILERBOARD2);
+
+				if (snapshot.paused && !snapshot.gameOver && !snapshotP2.gameOver)
+					window.draw(pauseMenu);
+			}
+			else if (currentScreen == LOSESCREEN) {
+				window.clear(BLACK);
+				window.draw(lossText[lossBanner]);
+				window.draw(lossText[LOSSBANNERCOUNT]);
+				if (exporter.isSaving())
+					window.draw(lossText[LOSSBANNERCOUNT + 2]);
+				else if (!recorder.getFrames().empty()) // Replay prompt
+					window.draw(lossText[LOSSBANNERCOUNT + 1]);
+			}
+			else if (currentScreen == SPECTATE) {
+				window.clear(BLACK);
+				spectatorSnapshots.clear();
+				for (int i = 0; i < spectators.size(); i++)
+					spectatorSnapshots.push_back(&simulation.getSpectatorSnapshot(i));
+				spectatorGrid.draw(window, spectatorSnapshots);
+			}
+			else if (currentScreen == SETTINGSCREEN) {
+				window.clear(BLUE);
+				PROFILE_BEGIN(PROFILERSETTINGS);
+				window.draw(gameSettings);
+				PROFILE_END(PROFILERSETTINGS);
+			}
+			profiler.draw(window);
+		}
+		frames.endFrame(window);
+		if (frames.isDrawing())
+			assets.onFrameShown();
+		profiler.endFrame();
+		if (frames.isDrawing() && (currentScreen == CLASSIC || currentScreen == SANDBOX || currentScreen == MULTIPLAYER))
+			latency.onDisplayed(frameSequence, getInputTime());
+		if (latency.isFinished())
+			window.close();
 	}
+	latency.printReport();
+	bgm.printCost();
 
-	// Cleanup
+	// Cleanup. The simulation thread is joined before anything it uses is deleted
+	keyListener.stop();
+	simulation.stop();
+	configWatcher.stop();
 	delete sandboxMenu;
 	delete playerSoloKeys;
 	delete player1Keys;
@@ -610,7 +714,9 @@ int main() {
 	delete player2DAS;
 	delete screen;
 	delete screenP2;
+	for (Screen* spectator : spectators)
+		delete spectator;
 	delete soundFX;
-	delete cursor;
+	delete spectatorFX;
 	return 0;
 }
@@ -22,10 +22,49 @@ namespace TetrisVariables {
 	const int GAMEWIDTH = TILESIZE * NUMCOLS, GAMEHEIGHT = TILESIZE * NUMROWS;
 
 	// Game mechanic related variables
-	const int FPS = 60; // Frame limit of the game
+	const int FPS = 60; // Frame limit of the game in capped mode, and wake rate of frames that are not drawn
+	// Frame rate settings. Drawing can follow the display refresh rate since game timing runs on the simulation thread
+	const int RENDERCAPPED = 0, RENDERVSYNC = 1, RENDERUNCAPPED = 2;
+	// Background music either streams from its file or is decoded into memory once
+	const int BGMSTREAM = 0, BGMPRELOAD = 1;
+	const int BGMSTREAMBUFFERSECONDS = 4; // SFML keeps one second of samples for decoding and three queued buffers of the same size
+	const int IDLEFPS = 10; // Loop rate on static screens once nothing has changed for IDLEDELAY seconds
+	const float IDLEDELAY = 1;
+	const int TICKRATE = 240; // Simulation ticks per second. Runs on its own thread, independent of FPS
+	const int INPUTQUEUESIZE = 256; // Key changes waiting for the simulation
+	const int KEYLISTENERWAKEDELAY = 100; // Milliseconds the key listener waits for events before checking if it should stop
+	// Frame profiler zones. Only measured in builds with TETRIS_PROFILER
+	const int PROFILERFRAME = 0, PROFILERINPUT = 1, PROFILERDAS = 2, PROFILERTIMERS = 3,
+		PROFILERBOARD1 = 4, PROFILERBOARD2 = 5, PROFILERHUD = 6, PROFILERSETTINGS = 7, PROFILERDISPLAY = 8;
+	const int PROFILERZONECOUNT = 9;
+	const string PROFILERZONENAMES[] = { "Frame", "Input", "DAS", "Timers", "Board 1", "Board 2", "HUD", "Settings", "Display" };
+	const int PROFILERWINDOW = 240, PROFILERGRAPHHEIGHT = 60; // Frames in the rolling window. Graph height in pixels
+	const float PROFILERREFRESH = 0.25f; // Seconds between overlay text updates
+	// Input to photon latency harness. Only measured in builds with TETRIS_LATENCY
+	const int LATENCYSHIFT = 0, LATENCYROTATE = 1, LATENCYHARDDROP = 2, LATENCYHOLD = 3, LATENCYACTIONCOUNT = 4;
+	const string LATENCYACTIONNAMES[] = { "Shift", "Rotate", "Hard drop", "Hold" };
+	const int LATENCYBUCKETS = 50, LATENCYBARWIDTH = 40; // One millisecond per bucket. The last also counts anything slower
+	const int LATENCYSCRIPTLENGTH = 5; // Keys cycled by injected presses
+	const float LATENCYINJECTPERIOD = 120, LATENCYINJECTHOLD = 30; // Milliseconds between injected presses and how long each is held
+	// Replay export. Classic games are recorded and can be saved from the loss screen
+	const int RASTERCELLSIZE = 12; // Pixels per cell in thumbnails and videos
+	const int REPLAYFPS = 30, REPLAYMAXFRAMES = REPLAYFPS * 60 * 15; // Recording stops after 15 minutes
+	const int REPLAYBATCHFRAMES = 8; // Frames per export thread between writes
+	// Spectator grid. Boards are played by bots to show a full tournament view
+	const int SPECTATORBOARDCOUNT = 64;
+	const float SPECTATORACTIONDELAY = 0.1f, SPECTATORRESETDELAY = 2; // Seconds
 	const float LOCKDELAY = 0.5f; // Delay before a piece sets in seconds
 	const float SUPERLOCKDELAY = 3; // Lock delay to prevent infinites
 	const int NEXTPIECECOUNT = 6; // Number of next pieces visible. Will crash if above 7.
+	const int CLEARANIMATIONCOUNT = 5; // Speed up, clear, back-to-back, combo, and all clear texts
+	// Names shown by the clear text, indexed by clear type
+	const vector<string> CLEARNAMES = { "T-spin Single", "T-spin Double", "Double", "T-spin Triple", "Triple", "Tetris" };
+	const int TSPINSINGLECLEAR = 0, TSPINDOUBLECLEAR = 1, DOUBLECLEAR = 2, TSPINTRIPLECLEAR = 3, TRIPLECLEAR = 4, TETRISCLEAR = 5;
+	const int MAXEFFECTS = 64; // Effects a board can run at once. The oldest is replaced when full
+	const int TEXTEFFECT = 0, DEATHEFFECT = 1, FLASHEFFECT = 2, PARTICLEEFFECT = 3; // Effect kinds
+	const float LINEFLASHDURATION = 0.25f, PARTICLEDURATION = 0.6f; // Line clear effects in seconds
+	const int PARTICLECOUNT = 8; // Particles thrown per cleared line
+	const float PARTICLESPEED = 400, PARTICLEGRAVITY = 1200, PARTICLESIZE = 4; // Pixels and seconds
 	const int GRAVITYTIERLINES[] = { 0, 40, 80, 100, 120, 160, 220 }; // Lines required to set speed of the same index
 	const float GRAVITYSPEEDS[] = { 1, 0.6f, 0.25f, 0.1f, 0.05f, 0.02f, 0.01f }; // Time needed for a piece to fall once
 	const float DEFAULTGRAVITY = GRAVITYSPEEDS[0]; // Time between gravity movements in seconds
@@ -40,6 +79,12 @@ namespace TetrisVariables {
 	const float DASDELAY = 170, DASSPEED = 50;
 	vector<float> DASDELAYVALUES{ 340, 170, 50, 0 };
 	vector<float> DASSPEEDVALUES{ 100, 50, 25, 0 };
+	const int INSTANTREPEAT = REALNUMROWS; // Moves owed per tick by a 0 ms auto repeat. Enough to cross the board
+	// Player actions. Numbered in the order of KeySet::getSet
+	const int ACTIONNONE = -1, ACTIONHARDDROP = 0, ACTIONLEFT = 1, ACTIONDOWN = 2, ACTIONRIGHT = 3, ACTIONSPINCW = 4, ACTIONSPINCCW = 5, ACTIONHOLD = 6;
+	const int ACTIONCOUNT = 7;
+	const int LATENCYACTIONS[ACTIONCOUNT] = { LATENCYHARDDROP, LATENCYSHIFT, LATENCYSHIFT, LATENCYSHIFT, LATENCYROTATE, LATENCYROTATE, LATENCYHOLD };
+	const int COMMANDBUFFERSIZE = 64; // Commands a board can take per tick
 
 	// Rectangle positions
 	const float MENUXPOS = WIDTH / 1.7f, MENUYPOS = HEIGHT / 2 - 40;
@@ -51,7 +96,7 @@ namespace TetrisVariables {
 	const sf::Vector2f SANDBOXMENUPOS(GAMEXPOS + GAMEWIDTH + LINEWIDTH * 2, GAMEYPOS + GAMEHEIGHT / 1.5f);
 	const sf::Vector2f ORIGIN(0, 0);
 	// Game screen state codes
-	const int MAINMENU = 1, CLASSIC = 2, SANDBOX = 3, MULTIPLAYER = 4, LOSESCREEN = 5, SETTINGSCREEN = 6;
+	const int MAINMENU = 1, CLASSIC = 2, SANDBOX = 3, MULTIPLAYER = 4, LOSESCREEN = 5, SETTINGSCREEN = 6, SPECTATE = 7;
 	// Set color constants for easy use and passing to functions
 	const sf::Color WHITE(255, 255, 255);
 	const sf::Color BLACK(0, 0, 0);
@@ -74,6 +119,10 @@ namespace TetrisVariables {
 		{RED, MAGENTA, YELLOW, CYAN, BLUE, GREEN, GRAY}, 
 		{GRAY, GRAY, GRAY, GRAY, GRAY, GRAY, GRAY}
 	};
+	// Board cells are packed into a byte. Low bits are a color index: a piece code, or GARBAGECOLOR for
+	// garbage and sandbox blocks. High bits mark a locked block, the falling piece, and the ghost piece
+	const unsigned char CELLCOLORMASK = 0x0F, CELLLOCKED = 0x10, CELLACTIVE = 0x20, CELLGHOST = 0x40;
+	const unsigned char GARBAGECOLOR = 7;
 	// Default keybinds
 
 	// Single player
@@ -107,17 +156,34 @@ namespace TetrisVariables {
 	UP, LEFT, DOWN, RIGHT, SPINCW, SPINCCW, HOLD,
 	UP1, LEFT1, DOWN1, RIGHT1, SPINCW1, SPINCCW1, HOLD1,
 	UP2, LEFT2, DOWN2, RIGHT2, SPINCW2, SPINCCW2, HOLD2,
-	0, 50, 50 };
+	0, 50, 50, RENDERVSYNC, BGMSTREAM };
+	// Config file keys in DEFAULTSETTINGS order. The file starts with a version line, then one key=value per line
+	const int CONFIGVERSION = 1;
+	const vector<string> CONFIGKEYS{ "startingSpeed", "nextPieceCount", "pieceHolding", "ghostPiece", "dasDelay", "dasSpeed",
+	"pieceRng", "rotationStyle", "garbageTimer", "garbageMultiplier", "garbageRng",
+	"solo.hardDrop", "solo.left", "solo.down", "solo.right", "solo.spinCW", "solo.spinCCW", "solo.hold",
+	"p1.hardDrop", "p1.left", "p1.down", "p1.right", "p1.spinCW", "p1.spinCCW", "p1.hold",
+	"p2.hardDrop", "p2.left", "p2.down", "p2.right", "p2.spinCW", "p2.spinCCW", "p2.hold",
+	"colorPalette", "bgmVolume", "sfxVolume", "frameRate", "musicLoading" };
 	const string CONFIGFILEPATH = "assets/config.cfg";
+	const int CONFIGWATCHDELAY = 100; // Milliseconds between checks for config file changes
 	const string SOUNDFXFILEPATH = "assets/sound-effects.ogg";
 	const string FONTFILEPATH = "assets/font.ttf";
 	const string BLOCKFILEPATH = "assets/tile_hidden.png";
 	const string BGMFILEPATH = "assets/tetris-theme.ogg";
+	// Assets loaded on worker threads at startup
+	const int ASSETFONT = 0, ASSETATLAS = 1, ASSETSOUNDS = 2, ASSETMUSIC = 3, ASSETCOUNT = 4;
+	const string ASSETNAMES[] = { "Font", "Block atlas", "Sound effects", "Music" };
+	const string ASSETPATHS[] = { FONTFILEPATH, BLOCKFILEPATH, SOUNDFXFILEPATH, BGMFILEPATH };
+	const string REPLAYFILEPATH = "replay.y4m", THUMBNAILFILEPATH = "replay.png";
+	const string SNAPSHOTFILEPATH = "replay.snapshots"; // Recorded frames, exported again with --export-replay
 	
-	// Audio timestamps for tetris-effects.ogg
+	// Sound effects in sound-effects.ogg. Each is cut into its own buffer at load
+	const int MEDIUMBEEP = 0, HIGHBEEP = 1, LIGHTTAP = 2, HIGHHIGHBEEP = 3, LOWBEEP = 4, LOWTHUD = 5;
+	const int SOUNDEFFECTCOUNT = 6;
+	const float SOUNDEFFECTSTARTS[] = { 1.8, 3.628, 3.655, 5.4, 7.2, 9 }; // In seconds
 	const float CLIPDURATION = 0.5;
-	const float LIGHTTAP = 3.655, MEDIUMBEEP = 1.8, HIGHBEEP = 3.628;
-	const float HIGHHIGHBEEP = 5.4, LOWBEEP = 7.2, LOWTHUD = 9;
+	const int SOUNDVOICECOUNT = 8; // Effects that can play at once. The oldest is cut off past that
 
 	// Constants for sprite classes
 
@@ -131,6 +197,9 @@ namespace TetrisVariables {
 	// Tab items
 	const float SETTINGXPOS = 50, SETTINGYPOS = 100, SETTINGSPACING = 50;
 	const float SELECTORRIGHTSPACING = 300, SELECTORDOWNSPACING = 40;
+	const int HITGRIDCELLSIZE = 50; // Cell size of the grid used to find selectors under the mouse
+	const float HITMARGIN = 15; // Selectors accept clicks slightly outside their sprites
+	const sf::BlendMode BLENDPREMULTIPLIED(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha); // For drawing render textures that were drawn over transparency
 	// Clickable button
 	const int BUTTONTEXTSIZE = 22;
 	// On-Off Switch
@@ -138,6 +207,9 @@ namespace TetrisVariables {
 	// BulletListSelector
 	const int BULLETNODERADIUS = 10, BULLETCURSORRADIUS = 6;
 
+	// Texture atlas cells for UI shapes, with spacing between cells
+	const int ATLASCELLSIZE = 32, ATLASPADDING = 2;
+
 	// Music track is loud at max volume, this constant provides a constant scalar
 	const float BGMVOLUME = 10, SFXVOLUME = 50;
 
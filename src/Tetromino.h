@@ -1,4 +1,6 @@
 #pragma once
+#include "TetrisConstants.h"
+#include "Atlas.h"
 using namespace std;
 using namespace TetrisVariables;
 
@@ -32,11 +34,10 @@ struct Tetromino {
 		return pieceCode;
 	}
 	virtual Tetromino* getNewPiece() = 0;
-	vector<sf::Sprite> getPieceSprite(sf::Texture& texture, float xPos, float yPos, float scaleFactor) {
+	vector<sf::Sprite> getPieceSprite(const TextureAtlas& atlas, float xPos, float yPos, float scaleFactor) {
 		vector<sf::Sprite> sprites;
 		for (sf::Vector2i* pos : positions) {
-			sf::Sprite sprite;
-			sprite.setTexture(texture);
+			sf::Sprite sprite(atlas.getTexture(), atlas.getTileRect());
 			sprite.setPosition(xPos + (pos->y - 3) * TILESIZE * scaleFactor, yPos + pos->x * TILESIZE * scaleFactor);
 			sprite.setScale(scaleFactor, scaleFactor);
 			sprite.setColor(color);
@@ -175,6 +176,7 @@ public:
 	Tetromino* getNewPiece() {
 		Tetromino* copy = new IPiece();
 		copy->setColor(color);
+		copy->setPieceCode(pieceCode);
 		return copy;
 	} 
 	vector<vector<sf::Vector2i>> spinCW() { // Special case, center changes. Notation document which orientation to change to
@@ -272,6 +274,7 @@ public:
 	Tetromino* getNewPiece() {
 		Tetromino* copy = new JPiece();
 		copy->setColor(color);
+		copy->setPieceCode(pieceCode);
 		return copy;
 	}
 };
@@ -286,6 +289,7 @@ public:
 	Tetromino* getNewPiece() {
 		Tetromino* copy = new LPiece();
 		copy->setColor(color);
+		copy->setPieceCode(pieceCode);
 		return copy;
 	}
 };
@@ -300,6 +304,7 @@ public:
 	Tetromino* getNewPiece() {
 		Tetromino* copy = new OPiece();
 		copy->setColor(color);
+		copy->setPieceCode(pieceCode);
 		return copy;
 	}
 	// Return current position to check. Will always rotate but does not do anything visually
@@ -321,6 +326,7 @@ public:
 	Tetromino* getNewPiece() {
 		Tetromino* copy = new SPiece();
 		copy->setColor(color);
+		copy->setPieceCode(pieceCode);
 		return copy;
 	}
 };
@@ -335,6 +341,7 @@ public:
 	Tetromino* getNewPiece() {
 		Tetromino* copy = new ZPiece();
 		copy->setColor(color);
+		copy->setPieceCode(pieceCode);
 		return copy;
 	}
 };
@@ -350,6 +357,7 @@ public:
 	Tetromino* getNewPiece() {
 		Tetromino* copy = new TPiece();
 		copy->setColor(color);
+		copy->setPieceCode(pieceCode);
 		return copy;
 	}
 	bool isTPiece(){
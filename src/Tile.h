@@ -1,83 +1,86 @@
 #pragma once
-#include "Tetromino.h"
+#include <algorithm>
+#include <SFML/Graphics.hpp>
+#include "TetrisConstants.h"
 
 using namespace std;
 using namespace TetrisVariables;
 
-class Tile : public sf::Drawable{
-	bool hasBlock; // For blocks that have dropped
-	bool hasMovingBlock; // For blocks that are still in control
-	bool hasPreviewBlock; // For block ghost piece
-	sf::Sprite sprite;
-	float xPos, yPos;
+// One board cell packed into a byte. Holds what occupies the cell and its color index.
+// Positions and sprites belong to the renderer, so boards are plain 220 byte arrays
+class Tile {
+	unsigned char state;
 
-	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const {
-		if (hasMovingBlock || hasBlock || hasPreviewBlock)
-			target.draw(sprite, states);
+	void setFlag(unsigned char flag, bool value) {
+		if (value)
+			state |= flag;
+		else
+			state &= ~flag;
+	}
+	void setColorIndex(int colorIndex) {
+		state = (state & ~CELLCOLORMASK) | (colorIndex & CELLCOLORMASK);
 	}
 public:
-	Tile(sf::Texture& texture, float xPos, float yPos) {
-		this->xPos = xPos;
-		this->yPos = yPos;
-		sprite.setPosition(xPos + 1, yPos + 1); // Very minor adjustment to help sprites stay within outlines
-		sprite.setTexture(texture);
-		hasBlock = false;
-		hasMovingBlock = false;
-		hasPreviewBlock = false;
-	}
-	// Move tile position down when clearing lines
-	void moveDown() { 
-		yPos += TILESIZE;
-		sprite.setPosition(xPos + 1, yPos + 1);
-	}
-	// Move tile position up when adding garbage
-	void moveUp() {
-		yPos -= TILESIZE;
-		sprite.setPosition(xPos + 1, yPos + 1);
-	}
-	void setColor(sf::Color& blockColor) {
-		sprite.setColor(blockColor);
-	}
-	void setColor(const sf::Color& blockColor) {
-		sprite.setColor(blockColor);
+	Tile() {
+		state = 0;
 	}
 	void setBlock(bool value) {
-		hasBlock = value;
-	}
-	void setBlock(bool value, sf::Color& blockColor) { // Overload to toggle drawing block and set color
-		hasBlock = value;
-		sprite.setColor(blockColor);
+		setFlag(CELLLOCKED, value);
 	}
-	void setBlock(bool value, const sf::Color& blockColor) { // Overload to toggle drawing block and set color
-		hasBlock = value;
-		sprite.setColor(blockColor);
+	void setBlock(bool value, int colorIndex) { // Overload to toggle drawing block and set color
+		setFlag(CELLLOCKED, value);
+		setColorIndex(colorIndex);
 	}
 	void setMovingBlock(bool value) {
-		hasMovingBlock = value;
+		setFlag(CELLACTIVE, value);
 	}
-	void setMovingBlock(bool value, sf::Color& blockColor) { // Overload to toggle drawing block and set color
-		hasMovingBlock = value;
-		sprite.setColor(blockColor);
+	void setMovingBlock(bool value, int colorIndex) { // Overload to toggle drawing block and set color
+		setFlag(CELLACTIVE, value);
+		setColorIndex(colorIndex);
 	}
 	void setPreviewBlock(bool value) {
-		hasPreviewBlock = value;
+		setFlag(CELLGHOST, value);
+	}
+	void setPreviewBlock(bool value, int colorIndex) { // Overload to toggle drawing block and set color
+		setFlag(CELLGHOST, value);
+		setColorIndex(colorIndex);
 	}
-	void setPreviewBlock(bool value, sf::Color& blockColor) { // Overload to toggle drawing block and set color
-		hasPreviewBlock = value;
-		sprite.setColor(blockColor);
+	// Empty the cell
+	void clear() {
+		state = 0;
 	}
-	sf::Sprite& getSprite() {
-		return sprite;
+	unsigned char getState() const {
+		return state;
 	}
-	bool getHasBlock() {
-		return hasBlock;
+	int getColorIndex() const {
+		return state & CELLCOLORMASK;
 	}
-	bool getHasMovingBlock() {
-		return hasMovingBlock;
+	bool getHasBlock() const {
+		return state & CELLLOCKED;
+	}
+	bool getHasMovingBlock() const {
+		return state & CELLACTIVE;
+	}
+	// True if the tile has anything to draw
+	bool isVisible() const {
+		return state & (CELLLOCKED | CELLACTIVE | CELLGHOST);
 	}
 	// Used for sandbox creative mode
 	void toggleBlock() {
-		sprite.setColor(WHITE);
-		hasBlock = !hasBlock;
+		setColorIndex(GARBAGECOLOR);
+		state ^= CELLLOCKED;
 	}
 };
+
+// Color of a packed cell in a pallete. Shared by every board drawer so they always match
+sf::Color getCellColor(unsigned char cell, int colorPallete) {
+	int colorIndex = cell & CELLCOLORMASK;
+	sf::Color color = colorIndex == GARBAGECOLOR ? WHITE : PIECECOLORSETS[colorPallete][colorIndex];
+	if (!(cell & (CELLLOCKED | CELLACTIVE))) // Ghost piece only
+		color.a = PREVIEWTRANSPARENCY;
+	return color;
+}
+// Red value of a garbage meter line. Goes from 127 to 255 with timer progress
+int getGarbageShade(float progress) {
+	return (int)((255 * min(max(progress, 0.0f), 1.0f) + 255) / 2);
+}